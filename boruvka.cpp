@@ -1,75 +1,179 @@
 #include "boruvka.hpp"
+#include "dsu.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <tuple>
-#include <unordered_set>
 #include <vector>
-#include <functional>
 
 using namespace std;
 
-vector<tuple<int, int, int, int>>
-	boruvka(const vector<tuple<int, int, int, int>>& edges, int n)
+// Edge still connecting two different components
+// from/to are the component representatives at the time of the last compaction
+template <typename W, typename I>
+struct WorkEdge
 {
-	vector<int> component(n, -1);
-	vector<int> cheapest(n, -1);
-	vector<tuple<int, int, int, int>> ans;
-	vector< vector<int> > selected_graph(n);
-
-	int m = static_cast<int>(edges.size());
-	int graph_cc = n;
-	while (graph_cc > 1)
+	I from, to, index;
+	W w;
+};
+
+// "no edge" / "no component" marker of the index arrays
+template <typename I>
+constexpr I NONE = numeric_limits<I>::max();
+
+// returns true if edge a is lighter than edge b
+// ties are broken by the edge index, so every round picks a forest and no cycle is formed
+template <typename W, typename I>
+static bool lighter(const WorkEdge<W, I>& a, const WorkEdge<W, I>& b)
+{
+	return a.w < b.w || (a.w == b.w && a.index < b.index);
+}
+
+// Reusable buffers of the rounds, allocated once
+template <typename W, typename I>
+struct CompactBuffers
+{
+	vector<WorkEdge<W, I>> sorted;
+	vector<I> start, seen, position;
+	vector<I> label; // label[v] = dsu.find(v), so the edge scans do plain array lookups
+};
+
+// takes a snapshot of the component of every vertex
+template <typename I>
+static void relabel(DSU<I>& dsu, I n, vector<I>& label)
+{
+	label.resize(n);
+	for (I v = 0; v < n; ++v) label[v] = dsu.find(v);
+}
+
+// drops the edges inside a component and keeps only the lightest edge between every pair of components
+// edges are bucketed by their smaller component, so no sorting or hashing is needed: O(m + n)
+template <typename W, typename I>
+static void compact(vector<WorkEdge<W, I>>& work, DSU<I>& dsu, I n, CompactBuffers<W, I>& buf)
+{
+	relabel(dsu, n, buf.label);
+
+	// counting sort of the edges between two components by their smaller component
+	buf.start.assign(n + 1, 0);
+	for (const WorkEdge<W, I>& e : work)
 	{
-		// tenho que descobrir as componentes do grafo já selecionado
-		fill(cheapest.begin(), cheapest.end(), -1);
-		fill(component.begin(), component.end(), -1);
-		int cur_cc = 0;
-
-		function<void(int, int)> explore = [&] (int root, int cc) {
-			component[root] = cc;
-			for(const auto& viz : selected_graph[root]) {
-				if(component[viz] == -1) explore(viz, cc);
-			}
-		};
+		I a = buf.label[e.from], b = buf.label[e.to];
+		if (a != b) buf.start[min(a, b) + 1]++;
+	}
+	partial_sum(buf.start.begin(), buf.start.end(), buf.start.begin());
+	buf.sorted.resize(buf.start[n]);
+	for (const WorkEdge<W, I>& e : work)
+	{
+		I a = buf.label[e.from], b = buf.label[e.to];
+		if (a == b) continue;
+		if (a > b) swap(a, b);
+		buf.sorted[buf.start[a]++] = {a, b, e.index, e.w};
+	}
+	// start[a] now holds the end of bucket a, which is the beginning of bucket a + 1
 
-		for(int i = 0; i < n; ++i) {
-			if(component[i] == -1) {
-				explore(i, cur_cc);
-				cur_cc++;
+	// inside a bucket, seen[b] tells whether (a, b) already has an edge and where it is in work
+	buf.seen.assign(n, NONE<I>);
+	buf.position.resize(n);
+	work.clear();
+	size_t j = 0;
+	for (I a = 0; a < n; ++a)
+	{
+		for (; j < static_cast<size_t>(buf.start[a]); ++j)
+		{
+			const WorkEdge<W, I>& e = buf.sorted[j];
+			if (buf.seen[e.to] != a)
+			{
+				buf.seen[e.to] = a;
+				buf.position[e.to] = static_cast<I>(work.size());
+				work.push_back(e);
 			}
+			else if (lighter(e, work[buf.position[e.to]]))
+			{
+				work[buf.position[e.to]] = e;
+			}
+		}
+	}
+}
+
+// this function returns the MST of the graph
+// components are kept in a DSU and the edge list shrinks every round
+// on a disconnected graph it stops when no component has an outgoing edge and returns a spanning forest
+template <typename W, typename I>
+vector<tuple<I, I, W, I>> boruvka(const vector<tuple<I, I, W, I>>& edges, I n, const atomic<bool>* cancel)
+{
+	DSU<I> dsu(n);
+	vector<I> cheapest(n, NONE<I>);
+	vector<tuple<I, I, W, I>> ans;
+
+	// edges that still connect two different components
+	vector<WorkEdge<W, I>> work;
+	work.reserve(edges.size());
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		I from, to;
+		W cost;
+		tie(from, to, cost, ignore) = edges[i];
+		work.push_back({from, to, static_cast<I>(i), cost});
+	}
+
+	CompactBuffers<W, I> buf;
+	relabel(dsu, n, buf.label);
+	vector<I> roots;
+
+	while (dsu.getComponentCount() > 1 && !work.empty())
+	{
+		// a round is O(m), so the flag is checked once per round
+		if (cancel && cancel->load(memory_order_relaxed))
+		{
+			return {};
 		}
 
-		for (int i = 0; i < m; ++i)
+		// cheapest edge leaving every component (as a position in work)
+		roots.clear();
+		for (size_t i = 0; i < work.size(); ++i)
 		{
-			int from, to, cost;
-			tie(from, to, cost, ignore) = edges[i];
-			to = component[to];
-			from = component[from];
+			I from = buf.label[work[i].from];
+			I to = buf.label[work[i].to];
 			if (from == to) continue;
-			if (cheapest[from] == -1 || cost < get<2>(edges[cheapest[from]]))
-				cheapest[from] = i;
-			if (cheapest[to] == -1 || cost < get<2>(edges[cheapest[to]]))
-				cheapest[to] = i;
+			if (cheapest[from] == NONE<I>) roots.push_back(from);
+			if (cheapest[to] == NONE<I>) roots.push_back(to);
+			if (cheapest[from] == NONE<I> || lighter(work[i], work[cheapest[from]])) cheapest[from] = static_cast<I>(i);
+			if (cheapest[to] == NONE<I> || lighter(work[i], work[cheapest[to]])) cheapest[to] = static_cast<I>(i);
 		}
-		
-		unordered_set<int> inserted_edges_id;
 
-		for (int i = 0; i < n; ++i)
+		// no component has an outgoing edge: the rest of the graph is disconnected
+		if (roots.empty()) break;
+
+		// an edge chosen by both of its components is only added once: the second unite fails
+		for (I root : roots)
 		{
-			if (cheapest[i] == -1) continue;
-
-			int from, to, cost, id;
-			tie(from, to, cost, id) = edges[cheapest[i]];
-			if(inserted_edges_id.find(id) != inserted_edges_id.end()) continue;
-			else {
-				selected_graph[from].push_back(to);
-				selected_graph[to].push_back(from);
-				inserted_edges_id.insert(id);
+			I from, to, id;
+			W cost;
+			tie(from, to, cost, id) = edges[work[cheapest[root]].index];
+			if (dsu.unite(from, to))
+			{
 				ans.emplace_back(from, to, cost, id);
-			}			
+			}
+			cheapest[root] = NONE<I>;
 		}
-		graph_cc = cur_cc;
+
+		compact(work, dsu, n, buf);
 	}
 
 	return ans;
-}
\ No newline at end of file
+}
+
+// The supported instantiations
+template vector<tuple<uint32_t, uint32_t, uint8_t, uint32_t>> boruvka(const vector<tuple<uint32_t, uint32_t, uint8_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, uint16_t, uint32_t>> boruvka(const vector<tuple<uint32_t, uint32_t, uint16_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, int32_t, uint32_t>> boruvka(const vector<tuple<uint32_t, uint32_t, int32_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, int64_t, uint32_t>> boruvka(const vector<tuple<uint32_t, uint32_t, int64_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, float, uint32_t>> boruvka(const vector<tuple<uint32_t, uint32_t, float, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, uint8_t, uint64_t>> boruvka(const vector<tuple<uint64_t, uint64_t, uint8_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, uint16_t, uint64_t>> boruvka(const vector<tuple<uint64_t, uint64_t, uint16_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, int32_t, uint64_t>> boruvka(const vector<tuple<uint64_t, uint64_t, int32_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, int64_t, uint64_t>> boruvka(const vector<tuple<uint64_t, uint64_t, int64_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, float, uint64_t>> boruvka(const vector<tuple<uint64_t, uint64_t, float, uint64_t>>&, uint64_t, const atomic<bool>*);
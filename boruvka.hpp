@@ -1,13 +1,22 @@
 #ifndef BORUVKA_H
 #define BORUVKA_H
 
+#include <atomic>
+#include <cstdint>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 using namespace std;
 
 // Implementation of Boruvka's algorithm for finding a MST
+// Components are maintained with a DSU, and after every round the edge list is compacted:
+// edges inside a component are dropped and only the lightest edge between two components is kept.
+// On a disconnected graph the result is a minimum spanning forest.
+// Edges are <from, to, weight, id> over the weight type W and the index type I (see prim.hpp).
+// If *cancel becomes true while the tree is computed, the computation stops and returns an empty result
 // Complexity: O(m log n)
-vector<tuple<int, int, int, int>> boruvka(const vector<tuple<int, int, int, int>>& edges, int n);
+template <typename W, typename I>
+vector<tuple<I, I, W, I>> boruvka(const vector<tuple<I, I, W, I>>& edges, I n, const atomic<bool>* cancel = nullptr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "client_commands.hpp"
+#include "trace.hpp"
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Helper: appends a 32 bit value in little-endian order
+static void appendLittleEndian(std::string& frame, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        frame += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+// Helper: parses a whole non-negative count, false for anything else (no exception for the client to see)
+static bool parseCount(const std::string& text, long& count) {
+    std::istringstream stream(text);
+    if (!(stream >> count) || count < 0) return false;
+    return (stream >> std::ws).eof();
+}
+
+// Reads the queries of a batch and streams back the packed results
+static void handleBatch(MST& mst, int socket, LineReader& reader, OutputBuffer& out, long count) {
+    TRACE_SCOPE_ID("batch", socket);
+    std::vector<DistanceQuery> queries;
+    queries.reserve(static_cast<size_t>(count));
+
+    std::string line;
+    for (long i = 0; i < count; ++i) {
+        if (!reader.readLine(line)) return;
+        std::istringstream queryStream(line);
+        std::string type;
+        DistanceQuery query{QueryType::Shortest, -1, -1};
+        queryStream >> type >> query.u >> query.v;
+        if (type == "L" || type == "longest") {
+            query.type = QueryType::Longest;
+        } else if (type == "B" || type == "bottleneck") {
+            query.type = QueryType::Bottleneck;
+        } else if (type == "G" || type == "graph") {
+            query.type = QueryType::GraphDistance;
+        } else if (type != "S" && type != "shortest") {
+            query.u = -1; // invalid query, answered with -1
+        }
+        queries.push_back(query);
+    }
+
+    std::vector<int64_t> results = mst.batchQuery(queries);
+
+    // The output buffer streams the line to the client while it grows
+    out.append("Batch results (" + std::to_string(results.size()) + "):\n");
+    std::string result;
+    for (size_t i = 0; i < results.size(); ++i) {
+        result = std::to_string(results[i]);
+        result += i + 1 < results.size() ? ' ' : '\n';
+        out.append(result);
+    }
+    if (results.empty()) {
+        out.append("\n");
+    }
+}
+
+// Sends the MST edges as one binary frame, the edge list is a segment of its own
+static void handleEdges(MST& mst, int socket, OutputBuffer& out) {
+    TRACE_SCOPE_ID("edges", socket);
+    std::vector<std::tuple<int, int, int64_t>> edges = mst.getEdges();
+
+    std::string header = EDGE_FRAME_MAGIC;
+    appendLittleEndian(header, static_cast<uint32_t>(edges.size()));
+
+    std::string payload;
+    payload.reserve(edges.size() * 12);
+    for (const auto& edge : edges) {
+        appendLittleEndian(payload, static_cast<uint32_t>(std::get<0>(edge)));
+        appendLittleEndian(payload, static_cast<uint32_t>(std::get<1>(edge)));
+        appendLittleEndian(payload, static_cast<uint32_t>(static_cast<int32_t>(std::get<2>(edge))));
+    }
+
+    out.append(header);
+    out.appendSegment(std::move(payload));
+}
+
+// Helper: an estimate with its interval and the sources it was computed from
+static std::string describeEstimate(const std::string& what, const Estimate& estimate, double confidence,
+                                    size_t vertices) {
+    std::ostringstream ss;
+    if (estimate.exact) {
+        ss << what << ": " << estimate.value << " (exact, " << estimate.sources << " sources)\n";
+    } else {
+        ss << what << ": ~" << estimate.value << " (";
+        if (confidence > 0) ss << confidence * 100 << "% confidence ";
+        ss << "interval [" << estimate.low << ", " << estimate.high << "], " << estimate.sources << " of "
+           << vertices << " sources)\n";
+    }
+    return ss.str();
+}
+
+// Average distance, exact (from the analysis) or estimated within the relative error
+static void handleAverage(MST& mst, size_t vertices, int socket, OutputBuffer& out, std::istringstream& args) {
+    TRACE_SCOPE_ID("average", socket);
+    std::string error;
+    if (!(args >> error)) {
+        std::ostringstream ss;
+        ss << "Average distance: " << mst.getAverageEdgeCount() << " (exact)\n";
+        out.append(ss.str());
+        return;
+    }
+    double relativeError = -1, confidence = 0.95;
+    try {
+        relativeError = std::stod(error);
+        std::string rest;
+        if (args >> rest) confidence = std::stod(rest);
+    } catch (const std::exception&) {
+        relativeError = -1;
+    }
+    if (!(relativeError > 0) || !(confidence > 0 && confidence < 1)) {
+        out.append("Usage: average [<relative error> [confidence]]\n");
+        return;
+    }
+    Estimate estimate = mst.estimateAverageEdgeCount(relativeError, confidence);
+    out.append(describeEstimate("Average distance", estimate, confidence, vertices));
+}
+
+// Diameter, exact or bounded within the relative error
+static void handleDiameter(MST& mst, size_t vertices, int socket, OutputBuffer& out, std::istringstream& args) {
+    TRACE_SCOPE_ID("diameter", socket);
+    double relativeError = 0;
+    std::string error;
+    if (args >> error) {
+        try {
+            relativeError = std::stod(error);
+        } catch (const std::exception&) {
+            relativeError = -1;
+        }
+        if (!(relativeError >= 0)) {
+            out.append("Usage: diameter [<relative error>]\n");
+            return;
+        }
+    }
+    Estimate estimate = mst.estimateDiameter(relativeError);
+    out.append(describeEstimate("Diameter", estimate, 0, vertices));
+}
+
+void serveCommands(const std::shared_ptr<const StoredGraph>& session, const ClientLimits& limits, int socket,
+                   LineReader& reader, OutputBuffer& out) {
+    MST mst = session->mst; // copies share the tree
+    std::string line;
+    // The thread serving the client is only held while the client keeps sending commands
+    reader.setIdleTimeout(limits.idleTimeout);
+    while (true) {
+        out.append("Enter a command (batch <count> | edges | average [error] | diameter [error] | save <name> | exit): ");
+        if (!reader.readLine(line)) break;
+
+        std::istringstream commandStream(line);
+        std::string command;
+        commandStream >> command;
+        if (command == "exit") {
+            break;
+        } else if (command == "batch") {
+            std::string countText;
+            long count = -1;
+            commandStream >> countText;
+            if (!parseCount(countText, count)) {
+                out.append("Usage: batch <count>\n");
+                continue;
+            }
+            // The queries that follow would be read as commands, so a refused batch ends the session
+            if (count > limits.maxBatchQueries) {
+                out.append("Error: Batch too large, at most " + std::to_string(limits.maxBatchQueries) +
+                           " queries\n");
+                break;
+            }
+            handleBatch(mst, socket, reader, out, count);
+        } else if (command == "edges") {
+            handleEdges(mst, socket, out);
+        } else if (command == "average") {
+            handleAverage(mst, session->graph.getVertexCount(), socket, out, commandStream);
+        } else if (command == "diameter") {
+            handleDiameter(mst, session->graph.getVertexCount(), socket, out, commandStream);
+        } else if (command == "save") {
+            std::string name;
+            if (!(commandStream >> name)) {
+                out.append("Usage: save <name>\n");
+                continue;
+            }
+            try {
+                graphStore().put(name, session);
+                out.append("Graph saved as " + name + "\n");
+            } catch (const std::exception& e) {
+                out.append(std::string("Error: ") + e.what() + "\n");
+            }
+        } else {
+            out.append("Unknown command: " + command + "\n");
+        }
+    }
+    if (reader.timedOut()) {
+        out.append("\nIdle for " + std::to_string(limits.idleTimeout) + " seconds, closing the connection\n");
+    }
+    out.flush();
+}
@@ -0,0 +1,34 @@
+#ifndef CLIENT_COMMANDS_HPP
+#define CLIENT_COMMANDS_HPP
+
+#include <memory>
+#include "graph_store.hpp"
+#include "line_reader.hpp"
+#include "output_buffer.hpp"
+#include "server_config.hpp"
+
+// Magic of the binary MST edge frame
+#define EDGE_FRAME_MAGIC "MSTE"
+
+// Serves the commands a client can send once the analysis of its MST was sent:
+//   batch <count>   followed by <count> lines "<L|S|B|G> <u> <v>" (longest / shortest distance on the MST, both
+//                   the weight of the tree path, heaviest edge on the tree path, shortest distance in the graph,
+//                   see MST::getLongestDistance, getShortestDistance, getBottleneckDistance and getGraphDistance),
+//                   answered with one line holding all the results in the order of the queries;
+//                   a count above limits.maxBatchQueries is refused and ends the session
+//   edges           the MST edges in one binary frame: "MSTE", uint32 edge count, then for every edge
+//                   uint32 from, uint32 to, int32 weight (all little-endian)
+//   average [error [confidence]]
+//                   average distance of the connected pairs: exact without arguments, otherwise estimated
+//                   from sampled sources until the confidence interval (default 95%) is within the relative error
+//   diameter [error] diameter (longest shortest path): exact without an argument, otherwise bounded from
+//                   sampled sources until the upper bound is within the relative error of the lower one
+//   save <name>     keeps the graph and its MST in the store of the server under the name
+//                   (loaded by "load <name>" instead of the number of vertices)
+//   exit            ends the session (so does closing the connection)
+// A client silent for longer than limits.idleTimeout (between commands or in a batch) is told so and the
+// session ends. The answers go through out, which is flushed before returning.
+void serveCommands(const std::shared_ptr<const StoredGraph>& session, const ClientLimits& limits, int socket,
+                   LineReader& reader, OutputBuffer& out);
+
+#endif // CLIENT_COMMANDS_HPP
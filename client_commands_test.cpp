@@ -0,0 +1,130 @@
+// Tests of the commands served once the MST analysis was sent (client_commands.cpp), driven over a socket pair:
+//   - the batch queries by letter and by name, with the invalid and unreachable ones answered -1
+//   - a malformed batch count is answered with the usage and the session goes on
+//   - a batch above --max-batch is refused and ends the session, a batch cut short is not answered
+//   - a client silent for longer than the idle timeout is told so and the session ends
+//
+// Usage: ./client_commands_test (exits with 1 if a check failed), "make test" builds and runs it
+
+#include "client_commands.hpp"
+#include "test_util.hpp"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Triangle 0-1-2 (weights 2, 2, 3, the MST keeps the two 2s) and the separate edge 3-4 (weight 5)
+static std::shared_ptr<const StoredGraph> forestSession() {
+    Graph graph(5);
+    graph.addEdge(0, 1, 2);
+    graph.addEdge(1, 2, 2);
+    graph.addEdge(0, 2, 3);
+    graph.addEdge(3, 4, 5);
+    MST mst(graph, "prim");
+    return std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+}
+
+// Helper: serves the commands of input and returns everything sent back.
+// closeInput = the client closes its side once input is sent, otherwise it stays connected and silent.
+static std::string runSession(const std::string& input, const ClientLimits& limits, bool closeInput = true) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0) {
+        throw std::runtime_error("socketpair failed");
+    }
+    int client = sockets[0], server = sockets[1];
+    if (write(client, input.data(), input.size()) != static_cast<ssize_t>(input.size())) {
+        throw std::runtime_error("write failed");
+    }
+    if (closeInput) shutdown(client, SHUT_WR);
+
+    {
+        OutputBuffer out(server);
+        LineReader reader(server, "", &out);
+        serveCommands(forestSession(), limits, server, reader, out);
+    }
+    close(server);
+
+    std::string output;
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(client, buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, static_cast<size_t>(bytes));
+    }
+    close(client);
+    return output;
+}
+
+// Helper: true if text contains part
+static bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+static void testBatchQueries() {
+    ClientLimits limits;
+    // L and S are the tree path weight, B its heaviest edge, G the graph distance
+    std::string output = runSession("batch 12\nL 0 2\nS 0 2\nB 0 2\nG 0 2\n"
+                                    "longest 0 2\nshortest 0 2\nbottleneck 0 2\ngraph 0 2\n"
+                                    "L 0 3\nX 0 2\nB 0 9\nG 4\nexit\n",
+                                    limits);
+    CHECK(contains(output, "Batch results (12):\n4 4 2 3 4 4 2 3 -1 -1 -1 -1\n"), output);
+
+    output = runSession("batch 0\nbatch 1\nG 3 4\n", limits);
+    CHECK(contains(output, "Batch results (0):\n\n"), output);
+    CHECK(contains(output, "Batch results (1):\n5\n"), output);
+}
+
+static void testMalformedCounts() {
+    ClientLimits limits;
+    const char* const counts[] = {"", " -1", " 3x", " abc", " 1.5"};
+    for (const char* count : counts) {
+        // The session goes on after the usage, the next batch is answered
+        std::string output = runSession(std::string("batch") + count + "\nbatch 1\nB 0 2\n", limits);
+        CHECK(contains(output, "Usage: batch <count>\n"), "batch" << count << ": " << output);
+        CHECK(contains(output, "Batch results (1):\n2\n"), "batch" << count << ": " << output);
+    }
+    std::string output = runSession("stats\nexit\n", limits);
+    CHECK(contains(output, "Unknown command: stats\n"), output);
+}
+
+static void testBatchLimit() {
+    ClientLimits limits;
+    limits.maxBatchQueries = 2;
+    std::string output = runSession("batch 2\nL 0 1\nL 1 2\n", limits);
+    CHECK(contains(output, "Batch results (2):\n2 2\n"), output);
+
+    // The refused queries are not read as commands: the session ends at the refusal
+    output = runSession("batch 3\nL 0 1\nL 0 1\nL 0 1\nbatch 1\nL 0 1\n", limits);
+    CHECK(contains(output, "Error: Batch too large, at most 2 queries\n"), output);
+    CHECK(!contains(output, "Batch results"), output);
+    CHECK(!contains(output, "Unknown command"), output);
+
+    // A batch cut short by the client closing is not answered
+    output = runSession("batch 3\nL 0 1\n", ClientLimits());
+    CHECK(!contains(output, "Batch results"), output);
+}
+
+static void testIdleTimeout() {
+    ClientLimits limits;
+    limits.idleTimeout = 1;
+    const char* const inputs[] = {"batch 1\nL 0 1\n", "batch 2\nL 0 1\n"}; // silent between commands, in a batch
+    for (const char* input : inputs) {
+        auto start = std::chrono::steady_clock::now();
+        std::string output = runSession(input, limits, false);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        CHECK(contains(output, "\nIdle for 1 seconds, closing the connection\n"), output);
+        CHECK(seconds >= 0.9 && seconds < 10, seconds);
+    }
+    std::string output = runSession("batch 2\nL 0 1\n", limits, false);
+    CHECK(!contains(output, "Batch results"), output);
+}
+
+int main() {
+    testBatchQueries();
+    testMalformedCounts();
+    testBatchLimit();
+    testIdleTimeout();
+
+    return finishTests("client_commands_test");
+}
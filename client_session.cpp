@@ -0,0 +1,164 @@
+#include "client_session.hpp"
+#include "graph_generator.hpp"
+#include "mst.hpp"
+#include <sstream>
+#include <stdexcept> // For exceptions
+
+ClientSession::ClientSession(const ClientLimits& limits)
+    : state(State::Vertices), limits(limits), remainingEdges(0), totalEdges(0), quietEdges(false) {
+    output = "----------Graph creation----------\nEnter the number of vertices: ";
+}
+
+void ClientSession::feed(const char* data, size_t len) {
+    input.append(data, len);
+
+    // Handle every complete line, a partial line stays in the buffer until the rest arrives
+    size_t start = 0;
+    size_t newline;
+    while (state != State::Ready && state != State::Failed &&
+           (newline = input.find('\n', start)) != std::string::npos) {
+        handleLine(input.substr(start, newline - start));
+        start = newline + 1;
+    }
+    input.erase(0, start);
+}
+
+void ClientSession::handleLine(const std::string& rawLine) {
+    // Trim whitespace and newline characters
+    std::string line = rawLine;
+    line.erase(line.find_last_not_of(" \t\n\r") + 1);
+
+    try {
+        switch (state) {
+            case State::Vertices: {
+                // A stored graph comes with its MST, the algorithm is not asked
+                std::string name;
+                if (parseLoadCommand(line, name)) {
+                    stored = graphStore().get(name);
+                    if (!stored) {
+                        throw std::invalid_argument("No stored graph named " + name);
+                    }
+                    output += describeStoredGraph(name, *stored);
+                    state = State::Ready;
+                    break;
+                }
+                // The graph can be generated by the server instead of uploaded
+                if (isGeneratorCommand(line)) {
+                    GeneratorSpec spec = parseGeneratorCommand(line);
+                    limits.checkVertices(spec.vertices);
+                    graph = generateGraph(spec);
+                    output += describeGeneratedGraph(spec, graph);
+                    finishGraph();
+                    break;
+                }
+                std::istringstream vertexStream(line);
+                long numVertices = -1;
+                if (!(vertexStream >> numVertices)) {
+                    throw std::invalid_argument("Invalid number of vertices");
+                }
+                // Reject a too large graph before its matrix is allocated
+                limits.checkVertices(numVertices);
+                // Create a new graph with the given number of vertices
+                graph = Graph(static_cast<int>(numVertices));
+                output += "Enter the number of edges: ";
+                state = State::Edges;
+                break;
+            }
+            case State::Edges: {
+                std::istringstream countStream(line);
+                long numEdges = -1;
+                std::string mode;
+                if (!(countStream >> numEdges)) {
+                    throw std::invalid_argument("Invalid number of edges");
+                }
+                countStream >> mode;
+                quietEdges = mode == "quiet";
+                limits.checkEdges(numEdges);
+                remainingEdges = totalEdges = static_cast<int>(numEdges);
+                if (remainingEdges <= 0) {
+                    finishGraph();
+                } else {
+                    if (!quietEdges) output += "Enter an edge (from, to, weight): ";
+                    state = State::Edge;
+                }
+                break;
+            }
+            case State::Edge: {
+                int from, to, weight;
+                std::istringstream edgeStream(line);
+                if (!(edgeStream >> from >> to >> weight)) {
+                    throw std::invalid_argument("Invalid edge: " + line);
+                }
+                graph.addEdge(from, to, weight);
+                if (quietEdges) {
+                    if (--remainingEdges == 0) {
+                        output += std::to_string(totalEdges) + " edges added successfully!\n";
+                        finishGraph();
+                    }
+                    break;
+                }
+                output += "Edge from " + std::to_string(from) + " -> " + std::to_string(to) + " with weight " +
+                          std::to_string(weight) + " added successfully!\n";
+                if (--remainingEdges == 0) {
+                    finishGraph();
+                } else {
+                    output += "Enter an edge (from, to, weight): ";
+                }
+                break;
+            }
+            case State::Algorithm:
+                // Rejected here, while the client can still be told
+                checkMSTAlgorithm(line);
+                algorithm = line;
+                state = State::Ready;
+                break;
+            default:
+                break;
+        }
+    } catch (const std::exception& e) {
+        output += std::string("Error: ") + e.what() + "\n";
+        state = State::Failed;
+    }
+}
+
+void ClientSession::finishGraph() {
+    output += "New graph created!\n";
+    output += "----------MST creation----------\nEnter the algorithm of MST (prim, boruvka, auto or race): ";
+    state = State::Algorithm;
+}
+
+bool ClientSession::hasOutput() const {
+    return !output.empty();
+}
+
+std::string ClientSession::takeOutput() {
+    std::string result;
+    result.swap(output);
+    return result;
+}
+
+bool ClientSession::isReady() const {
+    return state == State::Ready;
+}
+
+bool ClientSession::isFailed() const {
+    return state == State::Failed;
+}
+
+Graph ClientSession::takeGraph() {
+    return std::move(graph);
+}
+
+const std::string& ClientSession::getAlgorithm() const {
+    return algorithm;
+}
+
+std::shared_ptr<const StoredGraph> ClientSession::takeStoredGraph() {
+    return std::move(stored);
+}
+
+std::string ClientSession::takeRemainingInput() {
+    std::string result;
+    result.swap(input);
+    return result;
+}
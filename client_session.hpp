@@ -0,0 +1,58 @@
+#ifndef CLIENT_SESSION_HPP
+#define CLIENT_SESSION_HPP
+
+#include <memory>
+#include <string>
+#include "graph.hpp"
+#include "graph_store.hpp"
+#include "server_config.hpp"
+
+/**
+ * Class: ClientSession
+ * Per-connection state machine for the upload part of the protocol (graph creation and
+ * choice of MST algorithm). It is fed with the raw bytes received from the client and
+ * produces the same prompts as the blocking servers, so the asynchronous I/O backends
+ * can drive many clients from a single thread without blocking on any of them.
+ */
+class ClientSession {
+public:
+    explicit ClientSession(const ClientLimits& limits);
+
+    // Consumes bytes received from the client, every complete line advances the state machine
+    void feed(const char* data, size_t len);
+
+    // Output that has to be sent to the client
+    bool hasOutput() const;
+    std::string takeOutput();
+
+    // True once the graph and the algorithm were received
+    bool isReady() const;
+    // True if the client sent invalid input, the connection should be closed after the output
+    bool isFailed() const;
+
+    Graph takeGraph();
+    const std::string& getAlgorithm() const;
+    // Stored graph the client loaded instead of uploading one, nullptr otherwise
+    std::shared_ptr<const StoredGraph> takeStoredGraph();
+    // Bytes received after the algorithm line, they belong to the commands that follow
+    std::string takeRemainingInput();
+
+private:
+    enum class State { Vertices, Edges, Edge, Algorithm, Ready, Failed };
+
+    State state;
+    ClientLimits limits;
+    Graph graph;
+    std::string algorithm;
+    std::shared_ptr<const StoredGraph> stored;
+    int remainingEdges;
+    int totalEdges;
+    bool quietEdges;    // "<count> quiet": no prompt and no acknowledgement per edge
+    std::string input;  // bytes received but not yet terminated by a newline
+    std::string output; // prompts and answers waiting to be sent
+
+    void handleLine(const std::string& line);
+    void finishGraph();
+};
+
+#endif // CLIENT_SESSION_HPP
@@ -0,0 +1,46 @@
+#include "dsu.hpp"
+
+#include <numeric>
+#include <utility>
+
+using namespace std;
+
+template <typename I>
+DSU<I>::DSU(I n) : parent(n), size(n, 1), components(n)
+{
+	iota(parent.begin(), parent.end(), I(0));
+}
+
+template <typename I>
+I DSU<I>::find(I x)
+{
+	// iterative, so long chains can not overflow the stack
+	while (parent[x] != x)
+	{
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+template <typename I>
+bool DSU<I>::unite(I a, I b)
+{
+	a = find(a);
+	b = find(b);
+	if (a == b) return false;
+	if (size[a] < size[b]) swap(a, b);
+	parent[b] = a;
+	size[a] += size[b];
+	components--;
+	return true;
+}
+
+template <typename I>
+I DSU<I>::getComponentCount() const
+{
+	return components;
+}
+
+template class DSU<uint32_t>;
+template class DSU<uint64_t>;
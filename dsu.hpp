@@ -0,0 +1,31 @@
+#ifndef DSU_H
+#define DSU_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Disjoint set union (union-find) with path halving and union by size
+// I is the vertex index type, instantiated for uint32_t and uint64_t
+// Complexity: O(alpha(n)) amortized per operation
+template <typename I>
+class DSU
+{
+public:
+	DSU(I n);
+
+	// Returns the representative of the set containing x
+	I find(I x);
+	// Merges the sets of a and b, returns false if they were already in the same set
+	bool unite(I a, I b);
+	// Number of disjoint sets
+	I getComponentCount() const;
+
+private:
+	vector<I> parent;
+	vector<I> size;
+	I components;
+};
+
+#endif
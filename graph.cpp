@@ -2,22 +2,36 @@
 #include <stdexcept> // For exceptions
 
 // Constructor
-Graph::Graph(int vertices) : vertexCount(vertices), edgeCount(0) {
+template <typename W, typename I>
+BasicGraph<W, I>::BasicGraph(I vertices) : vertexCount(vertices), edgeCount(0) {
     // Initialize the adjacency matrix with zeros
-    adjMatrix.resize(vertices, vector<int>(vertices, 0));
+    adjMatrix.resize(vertices, vector<W>(vertices, 0));
 }
-Graph::Graph() : vertexCount(0), edgeCount(0) {
-    // Initialize the adjacency matrix with zeros
-    adjMatrix.resize(0, vector<int>(0, 0));
+template <typename W, typename I>
+BasicGraph<W, I>::BasicGraph() : vertexCount(0), edgeCount(0) {
+}
+
+template <typename W, typename I>
+BasicGraph<W, I>::BasicGraph(vector<vector<W>> matrix)
+    : vertexCount(static_cast<I>(matrix.size())), edgeCount(0), adjMatrix(std::move(matrix)) {
+    for (I u = 0; u < vertexCount; ++u) {
+        if (adjMatrix[u].size() != adjMatrix.size()) {
+            throw std::invalid_argument("Adjacency matrix must be square");
+        }
+        for (I v = u + 1; v < vertexCount; ++v) {
+            if (adjMatrix[u][v] != 0) edgeCount++;
+        }
+    }
 }
 
 // Function to add an edge between vertices u and v with a given weight
-void Graph::addEdge(int u, int v, int weight) {
-    // Check if the vertices are within the range
-    if (u < 0 || u >= vertexCount || v < 0 || v >= vertexCount) {
+template <typename W, typename I>
+void BasicGraph<W, I>::addEdge(I u, I v, W weight) {
+    // Check if the vertices are within the range (a negative index wraps around to a huge one)
+    if (u >= vertexCount || v >= vertexCount) {
         throw std::out_of_range("Vertex index out of range");
     }
-    if (weight <= 0) {
+    if (!(weight > 0)) {
         throw std::invalid_argument("Weight must be positive");
     }
     // Add the weight to the adjacency matrix
@@ -29,8 +43,9 @@ void Graph::addEdge(int u, int v, int weight) {
 }
 
 // Function to remove an edge between vertices u and v
-void Graph::removeEdge(int u, int v) {
-    if (u < 0 || u >= vertexCount || v < 0 || v >= vertexCount) {
+template <typename W, typename I>
+void BasicGraph<W, I>::removeEdge(I u, I v) {
+    if (u >= vertexCount || v >= vertexCount) {
         throw std::out_of_range("Vertex index out of range");
     }
     if (adjMatrix[u][v] != 0) {
@@ -41,16 +56,31 @@ void Graph::removeEdge(int u, int v) {
 }
 
 // Getter for vertex count
-int Graph::getVertexCount() const {
+template <typename W, typename I>
+I BasicGraph<W, I>::getVertexCount() const {
     return vertexCount;
 }
 
 // Getter for edge count
-int Graph::getEdgeCount() const {
+template <typename W, typename I>
+size_t BasicGraph<W, I>::getEdgeCount() const {
     return edgeCount;
 }
 
 // Getter for the adjacency matrix
-vector<vector<int>> Graph::getGraph() const {
+template <typename W, typename I>
+const vector<vector<W>>& BasicGraph<W, I>::getGraph() const {
     return adjMatrix;
 }
+
+// The supported instantiations
+template class BasicGraph<uint8_t, uint32_t>;
+template class BasicGraph<uint16_t, uint32_t>;
+template class BasicGraph<int32_t, uint32_t>;
+template class BasicGraph<int64_t, uint32_t>;
+template class BasicGraph<float, uint32_t>;
+template class BasicGraph<uint8_t, uint64_t>;
+template class BasicGraph<uint16_t, uint64_t>;
+template class BasicGraph<int32_t, uint64_t>;
+template class BasicGraph<int64_t, uint64_t>;
+template class BasicGraph<float, uint64_t>;
@@ -1,30 +1,43 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 using std::vector;
 
-class Graph {
+// Graph over the weight type W and the vertex index type I.
+// Instantiated (in graph.cpp) for W = uint8_t, uint16_t, int32_t, int64_t, float and I = uint32_t, uint64_t.
+template <typename W, typename I = uint32_t>
+class BasicGraph {
 public:
+    using Weight = W;
+    using Index = I;
+
     // Constructor
-    Graph(int vertices);
+    BasicGraph(I vertices);
     // empty costructor
-    Graph();
+    BasicGraph();
+    // Adopts a square, symmetric matrix of weights (0 = no edge) without copying it
+    explicit BasicGraph(vector<vector<W>> matrix);
 
     // Functions to add and remove edges
-    void addEdge(int u, int v, int weight);
-    void removeEdge(int u, int v);
+    void addEdge(I u, I v, W weight);
+    void removeEdge(I u, I v);
 
     // Getters
-    int getVertexCount() const;
-    int getEdgeCount() const;
-    vector<vector<int>> getGraph() const;
+    I getVertexCount() const;
+    size_t getEdgeCount() const;
+    const vector<vector<W>>& getGraph() const;
 
 private:
-    int vertexCount;
-    int edgeCount;
-    vector<vector<int>> adjMatrix; // Adjacency matrix to store weights of edges
+    I vertexCount;
+    size_t edgeCount;
+    vector<vector<W>> adjMatrix; // Adjacency matrix to store weights of edges
 };
 
+// Graph uploaded by the clients: the protocol carries integer weights
+using Graph = BasicGraph<int32_t, uint32_t>;
+
 #endif // GRAPH_HPP
@@ -0,0 +1,202 @@
+#include "graph_generator.hpp"
+#include "helper_threads.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept> // For exceptions
+#include <thread>
+#include <vector>
+
+#define ROWS_PER_TASK 16 // Rows a thread takes at once from the shared counter
+
+static const char* GENERATE_USAGE = "Usage: generate <sparse|dense|grid|geometric|complete> <vertices> [param] [seed]";
+
+bool isGeneratorCommand(const std::string& line) {
+    return line.compare(0, 8, "generate") == 0;
+}
+
+GeneratorSpec parseGeneratorCommand(const std::string& line) {
+    std::istringstream ss(line);
+    std::string command, kind;
+    GeneratorSpec spec;
+    if (!(ss >> command >> kind >> spec.vertices) || command != "generate") {
+        throw std::invalid_argument(GENERATE_USAGE);
+    }
+    if (kind == "sparse") {
+        spec.kind = GeneratorKind::Sparse;
+    } else if (kind == "dense") {
+        spec.kind = GeneratorKind::Dense;
+    } else if (kind == "grid") {
+        spec.kind = GeneratorKind::Grid;
+    } else if (kind == "geometric") {
+        spec.kind = GeneratorKind::Geometric;
+    } else if (kind == "complete") {
+        spec.kind = GeneratorKind::Complete;
+    } else {
+        throw std::invalid_argument(GENERATE_USAGE);
+    }
+
+    // Optional param and seed
+    std::string rest;
+    if (ss >> rest) {
+        spec.param = std::stod(rest);
+        if (ss >> rest) spec.seed = std::stoull(rest);
+    }
+    if (spec.param < 0) {
+        throw std::invalid_argument(GENERATE_USAGE);
+    }
+    return spec;
+}
+
+std::string generatorKindName(GeneratorKind kind) {
+    switch (kind) {
+        case GeneratorKind::Dense:
+            return "dense";
+        case GeneratorKind::Grid:
+            return "grid";
+        case GeneratorKind::Geometric:
+            return "geometric";
+        case GeneratorKind::Complete:
+            return "complete";
+        default:
+            return "sparse";
+    }
+}
+
+std::string describeGeneratedGraph(const GeneratorSpec& spec, const Graph& graph) {
+    return "Generated " + generatorKindName(spec.kind) + " graph with " + std::to_string(graph.getVertexCount()) +
+           " vertices and " + std::to_string(graph.getEdgeCount()) + " edges\n";
+}
+
+// Helper: random generator of one row, seeded from the spec seed and the row only,
+// so the graph does not depend on the number of threads or on which thread filled the row
+static std::mt19937_64 rowRandom(uint64_t seed, uint64_t row) {
+    // splitmix64 finalizer, neighbouring rows get unrelated seeds
+    uint64_t z = seed + (row + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return std::mt19937_64(z ^ (z >> 31));
+}
+
+// Helper: random weight of an edge
+static int32_t randomWeight(std::mt19937_64& rng) {
+    return std::uniform_int_distribution<int32_t>(1, GENERATOR_MAX_WEIGHT)(rng);
+}
+
+// Helper: runs fill(u) for every row u, rows are handed out to the threads in small chunks
+// because the rows near the top of the matrix have more work (only v > u is generated)
+template <typename RowFiller>
+static void forEachRow(uint32_t n, unsigned threads, const RowFiller& fill) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<uint64_t>(threads, n / ROWS_PER_TASK + 1));
+
+    std::atomic<uint32_t> nextRow(0);
+    auto worker = [&]() {
+        uint32_t first;
+        while ((first = nextRow.fetch_add(ROWS_PER_TASK)) < n) {
+            uint32_t last = std::min<uint32_t>(n, first + ROWS_PER_TASK);
+            for (uint32_t u = first; u < last; ++u) fill(u);
+        }
+    };
+
+    // The other threads come from the budget shared by all the requests, see helper_threads.hpp
+    HelperThreads helpers(threads > 1 ? threads - 1 : 0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < helpers.count(); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+Graph generateGraph(const GeneratorSpec& spec, unsigned threads) {
+    TRACE_SCOPE("generateGraph");
+    if (spec.vertices < 0 || spec.vertices > static_cast<long>(UINT32_MAX)) {
+        throw std::length_error("Invalid number of vertices: " + std::to_string(spec.vertices));
+    }
+    const uint32_t n = static_cast<uint32_t>(spec.vertices);
+
+    // The rows are allocated (and zeroed) in parallel first, then every edge (u, v) with v > u is
+    // written by the thread of row u only, into [u][v] and [v][u], so no two threads write the same weight
+    std::vector<std::vector<int32_t>> matrix(n);
+    forEachRow(n, threads, [&](uint32_t u) { matrix[u].assign(n, 0); });
+
+    auto setEdge = [&matrix](uint32_t u, uint32_t v, int32_t weight) {
+        matrix[u][v] = weight;
+        matrix[v][u] = weight;
+    };
+
+    switch (spec.kind) {
+        case GeneratorKind::Sparse:
+        case GeneratorKind::Dense: {
+            // G(n, p): the gap to the next edge of the row is geometric, so a sparse row costs O(degree)
+            double p = spec.kind == GeneratorKind::Sparse ? (spec.param > 0 ? spec.param : 8) / std::max(1u, n - 1)
+                                                          : (spec.param > 0 ? spec.param : 0.5);
+            p = std::min(p, 1.0);
+            const double logSkip = std::log(1.0 - p);
+            forEachRow(n, threads, [&](uint32_t u) {
+                std::mt19937_64 rng = rowRandom(spec.seed, u);
+                std::uniform_real_distribution<double> uniform(0.0, 1.0);
+                uint64_t v = u;
+                while (true) {
+                    // p == 1: every pair, logSkip is -inf and the gap is always 0
+                    double gap = p >= 1.0 ? 0 : std::floor(std::log(1.0 - uniform(rng)) / logSkip);
+                    if (gap >= n) break;
+                    v += 1 + static_cast<uint64_t>(gap);
+                    if (v >= n) break;
+                    setEdge(u, static_cast<uint32_t>(v), randomWeight(rng));
+                }
+            });
+            break;
+        }
+        case GeneratorKind::Grid: {
+            uint32_t width = spec.param >= 1 ? static_cast<uint32_t>(std::min<double>(spec.param, n))
+                                              : static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+            width = std::max(1u, width);
+            forEachRow(n, threads, [&](uint32_t u) {
+                std::mt19937_64 rng = rowRandom(spec.seed, u);
+                if ((u + 1) % width != 0 && u + 1 < n) setEdge(u, u + 1, randomWeight(rng));
+                if (static_cast<uint64_t>(u) + width < n) setEdge(u, u + width, randomWeight(rng));
+            });
+            break;
+        }
+        case GeneratorKind::Geometric: {
+            // Points are drawn up front from the seed, every row then compares its point with the next ones
+            std::vector<double> x(n), y(n);
+            std::mt19937_64 rng = rowRandom(spec.seed, UINT64_MAX);
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            for (uint32_t u = 0; u < n; ++u) {
+                x[u] = uniform(rng);
+                y[u] = uniform(rng);
+            }
+            // Default radius: about 8 neighbours per point
+            const double radius = spec.param > 0 ? spec.param : std::sqrt(8.0 / (M_PI * std::max(1u, n)));
+            forEachRow(n, threads, [&](uint32_t u) {
+                for (uint32_t v = u + 1; v < n; ++v) {
+                    double dx = x[u] - x[v], dy = y[u] - y[v];
+                    double distance = std::sqrt(dx * dx + dy * dy);
+                    if (distance <= radius) {
+                        // Weight proportional to the distance, at least 1
+                        setEdge(u, v, 1 + static_cast<int32_t>(distance / radius * (GENERATOR_MAX_WEIGHT - 1)));
+                    }
+                }
+            });
+            break;
+        }
+        case GeneratorKind::Complete:
+            forEachRow(n, threads, [&](uint32_t u) {
+                std::mt19937_64 rng = rowRandom(spec.seed, u);
+                for (uint32_t v = u + 1; v < n; ++v) setEdge(u, v, randomWeight(rng));
+            });
+            break;
+    }
+
+    return Graph(std::move(matrix));
+}
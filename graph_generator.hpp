@@ -0,0 +1,45 @@
+#ifndef GRAPH_GENERATOR_HPP
+#define GRAPH_GENERATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include "graph.hpp"
+
+#define GENERATOR_MAX_WEIGHT 1000 // Heaviest edge of a generated graph
+
+// Families of synthetic graphs
+enum class GeneratorKind {
+    Sparse,    // random graph, param = average degree (default 8)
+    Dense,     // random graph, param = probability of every edge (default 0.5)
+    Grid,      // grid of rows of param vertices (default sqrt(vertices)), edges to the right and down neighbours
+    Geometric, // random points in the unit square, edge if closer than param (default: average degree ~8),
+               // weighted by distance
+    Complete   // every pair of vertices, param unused
+};
+
+// Parameters of a generated graph, the same spec always gives the same graph
+struct GeneratorSpec {
+    GeneratorKind kind = GeneratorKind::Sparse;
+    long vertices = 0;
+    double param = 0;  // 0 = the default of the kind
+    uint64_t seed = 1;
+};
+
+// Parses "generate <sparse|dense|grid|geometric|complete> <vertices> [param] [seed]".
+// Throws std::invalid_argument on a malformed command.
+GeneratorSpec parseGeneratorCommand(const std::string& line);
+
+// True if the line is a generate command (the answer to the number of vertices prompt)
+bool isGeneratorCommand(const std::string& line);
+
+// Builds the graph directly in a matrix allocated once and filled by `threads` threads
+// (0 = hardware concurrency). Edge weights are between 1 and GENERATOR_MAX_WEIGHT.
+Graph generateGraph(const GeneratorSpec& spec, unsigned threads = 0);
+
+// Name of the kind as used by the generate command
+std::string generatorKindName(GeneratorKind kind);
+
+// Line sent to the client once the graph was generated
+std::string describeGeneratedGraph(const GeneratorSpec& spec, const Graph& graph);
+
+#endif // GRAPH_GENERATOR_HPP
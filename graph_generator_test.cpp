@@ -0,0 +1,150 @@
+// Tests of the synthetic graphs (graph_generator.cpp):
+//   - the same spec gives the same graph with any number of threads, another seed a different one
+//   - every generated matrix is symmetric with an empty diagonal and weights in [1, GENERATOR_MAX_WEIGHT]
+//   - grid and complete graphs have exactly their edges, the random ones about the requested density
+//   - the generate command is parsed, a malformed one is refused
+//
+// Usage: ./graph_generator_test (exits with 1 if a check failed), "make test" builds and runs it
+
+#include "graph_generator.hpp"
+#include "helper_threads.hpp"
+#include "test_util.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+static const GeneratorKind KINDS[] = {GeneratorKind::Sparse, GeneratorKind::Dense, GeneratorKind::Grid,
+                                      GeneratorKind::Geometric, GeneratorKind::Complete};
+
+// Helper: spec of a generated graph
+static GeneratorSpec makeSpec(GeneratorKind kind, long vertices, double param = 0, uint64_t seed = 1) {
+    GeneratorSpec spec;
+    spec.kind = kind;
+    spec.vertices = vertices;
+    spec.param = param;
+    spec.seed = seed;
+    return spec;
+}
+
+// Helper: checks the matrix is a simple undirected graph with generated weights and its edge count is right
+static void checkWellFormed(const Graph& graph, const std::string& context) {
+    const auto& matrix = graph.getGraph();
+    uint32_t n = graph.getVertexCount();
+    size_t edges = 0;
+    bool symmetric = true, weightsInRange = true;
+    for (uint32_t u = 0; u < n; ++u) {
+        CHECK(matrix[u].size() == n && matrix[u][u] == 0, context << " row " << u);
+        for (uint32_t v = u + 1; v < n; ++v) {
+            int32_t weight = matrix[u][v];
+            symmetric = symmetric && weight == matrix[v][u];
+            if (weight != 0) {
+                ++edges;
+                weightsInRange = weightsInRange && weight >= 1 && weight <= GENERATOR_MAX_WEIGHT;
+            }
+        }
+    }
+    CHECK(symmetric, context);
+    CHECK(weightsInRange, context);
+    CHECK(edges == graph.getEdgeCount(), context << ": " << edges << " edges, " << graph.getEdgeCount() << " counted");
+}
+
+static void testDeterminism() {
+    // The threads come from the helper budget, which is the core count by default
+    setHelperThreadLimit(8);
+    for (GeneratorKind kind : KINDS) {
+        for (long n : {0L, 1L, 2L, 17L, 300L}) {
+            std::string context = generatorKindName(kind) + " " + std::to_string(n);
+            GeneratorSpec spec = makeSpec(kind, n, 0, 42);
+            Graph single = generateGraph(spec, 1);
+            checkWellFormed(single, context);
+            // The rows are seeded by the spec and the row only, not by the thread that filled them
+            for (unsigned threads : {2u, 3u, 8u}) {
+                CHECK(generateGraph(spec, threads).getGraph() == single.getGraph(), context << ", " << threads << " threads");
+            }
+            if (n >= 17) {
+                CHECK(generateGraph(makeSpec(kind, n, 0, 43), 1).getGraph() != single.getGraph(), context << ", seed 43");
+            }
+        }
+    }
+    setHelperThreadLimit(0);
+}
+
+static void testEdgeCounts() {
+    // Grid of rows of width vertices: width - 1 edges per full row, one down edge per vertex above the last row
+    for (long n : {1L, 12L, 13L, 100L}) {
+        for (double width : {0.0, 1.0, 5.0, 200.0}) {
+            Graph graph = generateGraph(makeSpec(GeneratorKind::Grid, n, width), 2);
+            long w = width >= 1 ? std::min<long>(static_cast<long>(width), n)
+                                : static_cast<long>(std::ceil(std::sqrt(static_cast<double>(n))));
+            long right = 0;
+            for (long u = 0; u + 1 < n; ++u) {
+                if ((u + 1) % w != 0) ++right;
+            }
+            long down = std::max(0L, n - w);
+            CHECK(graph.getEdgeCount() == static_cast<size_t>(right + down),
+                  "grid " << n << " width " << width << ": " << graph.getEdgeCount());
+        }
+    }
+
+    Graph complete = generateGraph(makeSpec(GeneratorKind::Complete, 50), 4);
+    CHECK(complete.getEdgeCount() == 50 * 49 / 2, complete.getEdgeCount());
+    Graph full = generateGraph(makeSpec(GeneratorKind::Dense, 50, 1.0), 4);
+    CHECK(full.getEdgeCount() == 50 * 49 / 2, full.getEdgeCount());
+
+    // Random graphs: the expected edge count within a few standard deviations
+    const long n = 2000;
+    double pairs = n * (n - 1) / 2.0;
+    Graph sparse = generateGraph(makeSpec(GeneratorKind::Sparse, n, 8), 2);
+    double expected = pairs * 8 / (n - 1);
+    CHECK(std::abs(sparse.getEdgeCount() - expected) < 6 * std::sqrt(expected), sparse.getEdgeCount());
+    Graph dense = generateGraph(makeSpec(GeneratorKind::Dense, 400, 0.25), 2);
+    expected = 400 * 399 / 2.0 * 0.25;
+    CHECK(std::abs(dense.getEdgeCount() - expected) < 6 * std::sqrt(expected * 0.75), dense.getEdgeCount());
+    // Default radius: about 8 neighbours per point (fewer near the border of the square)
+    Graph geometric = generateGraph(makeSpec(GeneratorKind::Geometric, n), 2);
+    double degree = 2.0 * geometric.getEdgeCount() / n;
+    CHECK(degree > 6 && degree < 9, degree);
+}
+
+static void testParsing() {
+    GeneratorSpec spec = parseGeneratorCommand("generate grid 100 10 7");
+    CHECK(spec.kind == GeneratorKind::Grid && spec.vertices == 100 && spec.param == 10 && spec.seed == 7, "grid");
+    spec = parseGeneratorCommand("generate geometric 50 0.1");
+    CHECK(spec.kind == GeneratorKind::Geometric && spec.param == 0.1 && spec.seed == 1, "geometric");
+    spec = parseGeneratorCommand("generate complete 5");
+    CHECK(spec.kind == GeneratorKind::Complete && spec.vertices == 5 && spec.param == 0, "complete");
+    for (GeneratorKind kind : KINDS) {
+        CHECK(parseGeneratorCommand("generate " + generatorKindName(kind) + " 3").kind == kind, generatorKindName(kind));
+    }
+
+    CHECK(isGeneratorCommand("generate sparse 10") && !isGeneratorCommand("10") && !isGeneratorCommand("load g"),
+          "isGeneratorCommand");
+    const char* const malformed[] = {"generate", "generate sparse", "generate tree 10", "generate sparse ten",
+                                     "generate dense 10 -0.5", "generate dense 10 half", "generate sparse 10 8 seed"};
+    for (const char* line : malformed) {
+        bool refused = false;
+        try {
+            parseGeneratorCommand(line);
+        } catch (const std::invalid_argument&) {
+            refused = true;
+        }
+        CHECK(refused, line);
+    }
+
+    bool refused = false;
+    try {
+        generateGraph(makeSpec(GeneratorKind::Sparse, -1));
+    } catch (const std::length_error&) {
+        refused = true;
+    }
+    CHECK(refused, "-1 vertices");
+}
+
+int main() {
+    testDeterminism();
+    testEdgeCounts();
+    testParsing();
+
+    return finishTests("graph_generator_test");
+}
@@ -0,0 +1,360 @@
+#include "graph_store.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept> // For exceptions
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+GraphStore& graphStore() {
+    static GraphStore store;
+    return store;
+}
+
+bool parseLoadCommand(const std::string& line, std::string& name) {
+    std::istringstream ss(line);
+    std::string command;
+    if (!(ss >> command) || command != "load") return false;
+    if (!(ss >> name)) {
+        throw std::invalid_argument("Usage: load <name>");
+    }
+    return true;
+}
+
+std::string describeStoredGraph(const std::string& name, const StoredGraph& entry) {
+    return "Loaded graph " + name + " with " + std::to_string(entry.graph.getVertexCount()) + " vertices and " +
+           std::to_string(entry.graph.getEdgeCount()) + " edges, MST by " + entry.mst.getAlgorithm() + "\n";
+}
+
+// Helper: computes everything an MST computes on first use, so the sessions sharing it only read it
+static void completeAnalysis(const StoredGraph& entry) {
+    MST mst = entry.mst; // copies share the tree and its caches
+    mst.getAverageEdgeCount();
+    mst.getAverageEdgeCountPerComponent();
+}
+
+void GraphStore::put(const std::string& name, std::shared_ptr<const StoredGraph> entry) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!disabledReason.empty()) throw std::logic_error(disabledReason);
+    }
+    completeAnalysis(*entry);
+    std::lock_guard<std::mutex> lock(mutex);
+    graphs[name] = std::move(entry);
+    ++version;
+}
+
+std::shared_ptr<const StoredGraph> GraphStore::get(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!disabledReason.empty()) throw std::logic_error(disabledReason);
+    auto it = graphs.find(name);
+    return it == graphs.end() ? nullptr : it->second;
+}
+
+size_t GraphStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return graphs.size();
+}
+
+void GraphStore::disable(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    disabledReason = reason;
+}
+
+// Helpers: append a value or a string to a snapshot buffer
+template <typename T>
+static void appendValue(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void appendString(std::string& buffer, const std::string& value) {
+    appendValue(buffer, static_cast<uint32_t>(value.size()));
+    buffer.append(value);
+}
+
+static void appendEdge(std::string& buffer, uint32_t from, uint32_t to, int32_t weight) {
+    appendValue(buffer, from);
+    appendValue(buffer, to);
+    appendValue(buffer, weight);
+}
+
+// Helper: writes the whole buffer, retrying short writes
+static bool writeAll(int fd, const std::string& buffer) {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0) errno = EIO;
+        if (n <= 0) return false;
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Helper: one graph of a snapshot
+static std::string serializeGraph(const std::string& name, const StoredGraph& entry) {
+    const Graph& graph = entry.graph;
+    MST mst = entry.mst;
+    std::string buffer;
+    buffer.reserve(64 + name.size() + 12 * (graph.getEdgeCount() + graph.getVertexCount()));
+
+    appendString(buffer, name);
+    appendString(buffer, mst.getAlgorithm());
+    appendValue(buffer, static_cast<uint32_t>(graph.getVertexCount()));
+
+    appendValue(buffer, static_cast<uint64_t>(graph.getEdgeCount()));
+    for (uint32_t u = 0; u < graph.getVertexCount(); ++u) {
+        const std::vector<int32_t>& row = graph.getGraph()[u];
+        for (uint32_t v = u + 1; v < graph.getVertexCount(); ++v) {
+            if (row[v] != 0) appendEdge(buffer, u, v, row[v]);
+        }
+    }
+
+    std::vector<std::tuple<int, int, int64_t>> edges = mst.getEdges();
+    appendValue(buffer, static_cast<uint64_t>(edges.size()));
+    for (const auto& edge : edges) {
+        appendEdge(buffer, static_cast<uint32_t>(std::get<0>(edge)), static_cast<uint32_t>(std::get<1>(edge)),
+                   static_cast<int32_t>(std::get<2>(edge)));
+    }
+
+    MSTAnalytics analytics = mst.getAnalytics();
+    appendValue(buffer, analytics.averageEdgeCount);
+    appendValue(buffer, static_cast<uint32_t>(analytics.averageEdgeCountPerComponent.size()));
+    for (double average : analytics.averageEdgeCountPerComponent) {
+        appendValue(buffer, average);
+    }
+    return buffer;
+}
+
+// Helper: exception for a failed snapshot call, with the errno of that call
+static std::runtime_error snapshotError(const std::string& what, const std::string& path, int error) {
+    return std::runtime_error("Can not " + what + " snapshot " + path + ": " + strerror(error));
+}
+
+void GraphStore::writeSnapshot(const std::string& path) const {
+    TRACE_SCOPE("writeSnapshot");
+    // The entries are never modified, so they are written without holding the lock
+    std::map<std::string, std::shared_ptr<const StoredGraph>> copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        copy = graphs;
+    }
+
+    std::string tmpPath = path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw snapshotError("create", tmpPath, errno);
+
+    std::string header(SNAPSHOT_MAGIC);
+    appendValue(header, static_cast<uint32_t>(SNAPSHOT_VERSION));
+    appendValue(header, static_cast<uint32_t>(copy.size()));
+    bool ok = writeAll(fd, header);
+    for (auto it = copy.begin(); ok && it != copy.end(); ++it) {
+        ok = writeAll(fd, serializeGraph(it->first, *it->second));
+    }
+    // The errno of the failing call is kept before close and unlink can change it
+    int error = ok ? 0 : (errno != 0 ? errno : EIO);
+    const char* what = "write";
+    if (ok && fsync(fd) != 0) {
+        error = errno;
+        what = "sync";
+    }
+    if (close(fd) != 0 && error == 0) {
+        error = errno;
+        what = "close";
+    }
+    // The old snapshot is replaced only by a complete new one
+    if (error == 0 && rename(tmpPath.c_str(), path.c_str()) != 0) {
+        error = errno;
+        what = "rename";
+    }
+    if (error != 0) {
+        unlink(tmpPath.c_str());
+        throw snapshotError(what, path, error);
+    }
+}
+
+// Reads the values of a mapped snapshot, throws if the file ends too early
+struct SnapshotReader {
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+
+    const char* take(size_t bytes) {
+        if (bytes > size - pos) throw std::runtime_error("Snapshot is truncated");
+        const char* at = data + pos;
+        pos += bytes;
+        return at;
+    }
+    template <typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+    std::string readString() {
+        uint32_t length = read<uint32_t>();
+        return std::string(take(length), length);
+    }
+};
+
+// Helper: one graph of a snapshot, its MST and analytics are restored as they were written
+static std::shared_ptr<const StoredGraph> readGraph(SnapshotReader& reader, std::string& name) {
+    name = reader.readString();
+    std::string algorithm = reader.readString();
+    uint32_t vertices = reader.read<uint32_t>();
+
+    std::vector<std::vector<int32_t>> matrix(vertices, std::vector<int32_t>(vertices, 0));
+    uint64_t edgeCount = reader.read<uint64_t>();
+    for (uint64_t i = 0; i < edgeCount; ++i) {
+        uint32_t from = reader.read<uint32_t>();
+        uint32_t to = reader.read<uint32_t>();
+        int32_t weight = reader.read<int32_t>();
+        if (from >= vertices || to >= vertices || from == to || weight <= 0) {
+            throw std::runtime_error("Snapshot has an invalid edge in graph " + name);
+        }
+        matrix[from][to] = weight;
+        matrix[to][from] = weight;
+    }
+    Graph graph(std::move(matrix));
+
+    uint64_t mstEdgeCount = reader.read<uint64_t>();
+    if (mstEdgeCount >= std::max<uint64_t>(vertices, 1)) {
+        throw std::runtime_error("Snapshot has an invalid MST in graph " + name);
+    }
+    std::vector<std::tuple<int, int, int64_t>> edges;
+    edges.reserve(mstEdgeCount);
+    for (uint64_t i = 0; i < mstEdgeCount; ++i) {
+        uint32_t from = reader.read<uint32_t>();
+        uint32_t to = reader.read<uint32_t>();
+        int32_t weight = reader.read<int32_t>();
+        if (from >= vertices || to >= vertices || graph.getGraph()[from][to] != weight) {
+            throw std::runtime_error("Snapshot has an invalid MST in graph " + name);
+        }
+        edges.emplace_back(from, to, weight);
+    }
+
+    MSTAnalytics analytics;
+    analytics.averageEdgeCount = reader.read<double>();
+    uint32_t components = reader.read<uint32_t>();
+    if (components > vertices) {
+        throw std::runtime_error("Snapshot has invalid analytics in graph " + name);
+    }
+    for (uint32_t c = 0; c < components; ++c) {
+        analytics.averageEdgeCountPerComponent.push_back(reader.read<double>());
+    }
+
+    MST mst(graph, algorithm, edges, std::move(analytics));
+    auto entry = std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+    completeAnalysis(*entry);
+    return entry;
+}
+
+size_t GraphStore::loadSnapshot(const std::string& path) {
+    TRACE_SCOPE("loadSnapshot");
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) return 0; // first start, nothing was written yet
+        throw std::runtime_error("Can not open snapshot " + path + ": " + strerror(errno));
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Can not read snapshot " + path + ": " + strerror(errno));
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        close(fd);
+        throw std::runtime_error("Snapshot " + path + " is empty");
+    }
+
+    // The file is mapped rather than read, the graphs are built straight from the page cache
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Can not map snapshot " + path + ": " + strerror(errno));
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    std::map<std::string, std::shared_ptr<const StoredGraph>> loaded;
+    try {
+        SnapshotReader reader{static_cast<const char*>(data), size};
+        if (std::string(reader.take(4), 4) != SNAPSHOT_MAGIC || reader.read<uint32_t>() != SNAPSHOT_VERSION) {
+            throw std::runtime_error("Not a snapshot file (or a snapshot of another version)");
+        }
+        uint32_t count = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string name;
+            std::shared_ptr<const StoredGraph> entry = readGraph(reader, name);
+            loaded[name] = std::move(entry);
+        }
+    } catch (...) {
+        munmap(data, size);
+        throw;
+    }
+    munmap(data, size);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& graph : loaded) {
+        graphs[graph.first] = std::move(graph.second);
+    }
+    return loaded.size();
+}
+
+void GraphStore::startSnapshots(const std::string& path, unsigned intervalSeconds) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        size_t count = loadSnapshot(path);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "Loaded " << count << " stored graphs from " << path << " in " << ms.count() << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        // A damaged snapshot must not keep the server down, it is replaced by the next one
+        std::cerr << "Snapshot ignored: " << e.what() << std::endl;
+    }
+
+    uint64_t written;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        written = version;
+        stopping = false;
+    }
+    snapshotThread = std::thread([this, path, intervalSeconds, written]() mutable {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            bool stop = snapshotWakeup.wait_for(lock, std::chrono::seconds(intervalSeconds), [this]() { return stopping; });
+            uint64_t current = version;
+            if (current != written) {
+                // Written without the lock, the sessions keep storing graphs meanwhile
+                lock.unlock();
+                try {
+                    writeSnapshot(path);
+                    written = current;
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                }
+                lock.lock();
+            }
+            if (stop) return;
+        }
+    });
+}
+
+void GraphStore::stopSnapshots() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    snapshotWakeup.notify_all();
+    if (snapshotThread.joinable()) snapshotThread.join();
+}
+
+GraphStore::~GraphStore() {
+    stopSnapshots();
+}
@@ -0,0 +1,84 @@
+#ifndef GRAPH_STORE_HPP
+#define GRAPH_STORE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "graph.hpp"
+#include "mst.hpp"
+
+#define SNAPSHOT_MAGIC "MSTS" // First bytes of a snapshot file
+#define SNAPSHOT_VERSION 1
+
+// A graph kept by the server with its MST and analytics.
+// A stored graph is never modified, the sessions using it share it read-only.
+struct StoredGraph {
+    Graph graph;
+    MST mst;
+};
+
+/**
+ * Class: GraphStore
+ * Graphs kept resident by the server under a name, so a client (or another client after
+ * a restart) can load a graph with its MST instead of uploading it and recomputing everything.
+ * The store can be written to a snapshot file periodically by a background thread and is
+ * loaded back (with mmap) when the server starts.
+ *
+ * Snapshot format, in host byte order: SNAPSHOT_MAGIC, uint32 version, uint32 graph count, then
+ * for every graph: the name and the MST algorithm (uint32 length + bytes), uint32 vertex count,
+ * uint64 edge count + the edges, uint64 MST edge count + the MST edges (an edge is uint32 from,
+ * uint32 to, int32 weight), double average edge count, uint32 component count + one double each.
+ */
+class GraphStore {
+public:
+    // Keeps the graph under the name, replacing the graph stored under it before.
+    // The lazily computed analysis of the MST is completed first, so the entry is read-only from then on.
+    void put(const std::string& name, std::shared_ptr<const StoredGraph> entry);
+    // Graph stored under the name, nullptr if there is none
+    std::shared_ptr<const StoredGraph> get(const std::string& name) const;
+    size_t size() const;
+
+    // Makes put and get throw std::logic_error(reason) from then on, for a process whose stored graphs
+    // would not be seen by the other processes serving the same port (prefork mode)
+    void disable(const std::string& reason);
+
+    // Writes all the graphs to path (through a temporary file renamed over it).
+    // Throws std::runtime_error with the reason of the failing call on an I/O error.
+    void writeSnapshot(const std::string& path) const;
+    // Adds the graphs of the snapshot file, returns how many there were (0 if the file does not exist).
+    // Throws std::runtime_error if the file is not a valid snapshot.
+    size_t loadSnapshot(const std::string& path);
+
+    // Loads the snapshot at path, then writes a new one every intervalSeconds from a background
+    // thread whenever a graph was stored since the last one
+    void startSnapshots(const std::string& path, unsigned intervalSeconds);
+    // Writes the graphs stored since the last snapshot and joins the background thread
+    // (called by the destructor, so a snapshot is never cut short by the end of the process)
+    void stopSnapshots();
+    ~GraphStore();
+
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, std::shared_ptr<const StoredGraph>> graphs;
+    uint64_t version = 0; // incremented by every put
+    std::string disabledReason; // empty while the store is in use
+
+    std::thread snapshotThread;
+    std::condition_variable snapshotWakeup; // wakes the background thread early when it must stop
+    bool stopping = false;
+};
+
+// The store of the process, shared by all the sessions
+GraphStore& graphStore();
+
+// Parses "load <name>" (the answer to the number of vertices prompt), returns false for any other line
+bool parseLoadCommand(const std::string& line, std::string& name);
+
+// Line sent to the client that loaded a stored graph
+std::string describeStoredGraph(const std::string& name, const StoredGraph& entry);
+
+#endif // GRAPH_STORE_HPP
@@ -0,0 +1,254 @@
+// Tests of the stored graphs and their snapshots (graph_store.cpp):
+//   - a snapshot loaded back holds the same graphs, MSTs and analytics, and answers the same queries
+//   - a missing snapshot is an empty store, a truncated, empty or damaged one is refused without a change
+//   - a snapshot that can not be written fails with the reason and leaves no temporary file behind
+//   - the background thread writes the graphs stored since the last snapshot when it stops
+//   - "load <name>" is parsed, and in prefork mode the store refuses graphs and --snapshot is refused
+//
+// Usage: ./graph_store_test (exits with 1 if a check failed), "make test" builds and runs it
+
+#include "graph_generator.hpp"
+#include "graph_store.hpp"
+#include "server_config.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <unistd.h>
+
+// Helper: stored entry of the graph with its MST computed by algo
+static std::shared_ptr<const StoredGraph> makeEntry(Graph graph, const std::string& algo) {
+    MST mst(graph, algo);
+    return std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+}
+
+// Graphs of the round trip: generated ones, a forest, a single vertex and an empty graph
+static std::vector<std::pair<std::string, std::shared_ptr<const StoredGraph>>> storedGraphs() {
+    std::vector<std::pair<std::string, std::shared_ptr<const StoredGraph>>> entries;
+    GeneratorSpec spec;
+    spec.vertices = 60;
+    entries.emplace_back("sparse", makeEntry(generateGraph(spec, 1), "prim"));
+    spec.kind = GeneratorKind::Grid;
+    entries.emplace_back("grid", makeEntry(generateGraph(spec, 1), "boruvka"));
+
+    Graph forest(7);
+    forest.addEdge(0, 1, 2);
+    forest.addEdge(1, 2, 2);
+    forest.addEdge(0, 2, 3);
+    forest.addEdge(3, 4, 100000);
+    entries.emplace_back("forest with a long name", makeEntry(std::move(forest), "auto"));
+    entries.emplace_back("single", makeEntry(Graph(1), "prim"));
+    entries.emplace_back("empty", makeEntry(Graph(0), "boruvka"));
+    return entries;
+}
+
+// Helper: checks the loaded entry is the stored one
+static void checkSameEntry(const StoredGraph& stored, const StoredGraph& loaded, const std::string& name) {
+    MST expected = stored.mst, actual = loaded.mst;
+    CHECK(loaded.graph.getGraph() == stored.graph.getGraph(), name);
+    CHECK(loaded.graph.getEdgeCount() == stored.graph.getEdgeCount(), name);
+    CHECK(actual.getAlgorithm() == expected.getAlgorithm(), name << ": " << actual.getAlgorithm());
+    CHECK(actual.getEdges() == expected.getEdges(), name);
+    CHECK(actual.getAverageEdgeCount() == expected.getAverageEdgeCount(), name);
+    CHECK(actual.getAverageEdgeCountPerComponent() == expected.getAverageEdgeCountPerComponent(), name);
+    CHECK(actual.getTotalWeightPerComponent() == expected.getTotalWeightPerComponent(), name);
+    int n = static_cast<int>(stored.graph.getVertexCount());
+    for (int u = 0; u < n; u += 3) {
+        for (int v = 0; v < n; v += 5) {
+            CHECK(actual.getLongestDistance(u, v) == expected.getLongestDistance(u, v), name << " " << u << "-" << v);
+            CHECK(actual.getGraphDistance(u, v) == expected.getGraphDistance(u, v), name << " " << u << "-" << v);
+        }
+    }
+}
+
+// Helper: contents of a file, "" if it can not be read
+static std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+// Helper: true if loading the file into a store holding one graph throws and leaves that graph alone
+static bool refusedWithoutChange(const std::string& path) {
+    GraphStore store;
+    store.put("kept", makeEntry(Graph(2), "prim"));
+    bool refused = false;
+    try {
+        store.loadSnapshot(path);
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    return refused && store.size() == 1 && store.get("kept") != nullptr;
+}
+
+// Helper: the 32 bit value written at offset replaced by value
+static std::string patched(std::string data, size_t offset, uint32_t value) {
+    std::memcpy(&data[offset], &value, sizeof(value));
+    return data;
+}
+
+static void testRoundTrip(const std::string& dir) {
+    std::string path = dir + "/store.snap";
+    auto entries = storedGraphs();
+    GraphStore store;
+    for (const auto& entry : entries) store.put(entry.first, entry.second);
+    // Saving under an existing name replaces the graph
+    store.put("single", entries[3].second);
+    CHECK(store.size() == entries.size(), store.size());
+    store.writeSnapshot(path);
+    CHECK(access((path + ".tmp").c_str(), F_OK) != 0, "temporary file left");
+
+    GraphStore loaded;
+    CHECK(loaded.loadSnapshot(path) == entries.size(), "graphs loaded");
+    for (const auto& entry : entries) {
+        std::shared_ptr<const StoredGraph> copy = loaded.get(entry.first);
+        CHECK(copy != nullptr, entry.first);
+        if (copy) checkSameEntry(*entry.second, *copy, entry.first);
+    }
+    CHECK(loaded.get("missing") == nullptr, "missing");
+
+    // A snapshot of the loaded store is the same file
+    std::string again = dir + "/again.snap";
+    loaded.writeSnapshot(again);
+    CHECK(readFile(again) == readFile(path), "second snapshot differs");
+
+    GraphStore empty;
+    CHECK(empty.loadSnapshot(dir + "/missing.snap") == 0 && empty.size() == 0, "missing snapshot");
+}
+
+static void testDamagedSnapshots(const std::string& dir) {
+    std::string path = dir + "/damaged.snap";
+    GraphStore store;
+    Graph graph(3);
+    graph.addEdge(0, 1, 4);
+    graph.addEdge(1, 2, 5);
+    store.put("g", makeEntry(std::move(graph), "prim"));
+    std::string good = dir + "/good.snap";
+    store.writeSnapshot(good);
+    std::string data = readFile(good);
+
+    // Every prefix of the file is refused, from the empty file to the last byte missing
+    for (size_t size = 0; size < data.size(); ++size) {
+        writeFile(path, data.substr(0, size));
+        CHECK(refusedWithoutChange(path), size << " of " << data.size() << " bytes");
+    }
+
+    // Layout: magic, version, count, then "g" (4 + 1), "prim" (4 + 4), vertices, edge count, the 2 edges
+    // (from, to, weight), MST edge count, the MST edges, the analytics
+    const size_t edges = 12 + 5 + 8 + 4 + 8;
+    const size_t mstEdges = edges + 2 * 12 + 8;
+    const size_t analytics = mstEdges + 2 * 12;
+    const std::vector<std::pair<std::string, std::string>> damaged = {
+        {"magic", "MSTX" + data.substr(4)},
+        {"version", patched(data, 4, SNAPSHOT_VERSION + 1)},
+        {"graph count", patched(data, 8, 2)},
+        {"edge vertex", patched(data, edges, 3)},
+        {"edge loop", patched(data, edges + 4, 0)},
+        {"edge weight", patched(data, edges + 8, 0)},
+        {"MST edge count", patched(data, mstEdges - 8, 3)},
+        {"MST edge vertex", patched(data, mstEdges + 4, 7)},
+        {"MST edge weight", patched(data, mstEdges + 8, 6)},
+        {"component count", patched(data, analytics + 8, 4)},
+    };
+    for (const auto& file : damaged) {
+        CHECK(file.second.size() == data.size(), file.first);
+        writeFile(path, file.second);
+        CHECK(refusedWithoutChange(path), file.first);
+    }
+    writeFile(path, data);
+    GraphStore reloaded;
+    CHECK(reloaded.loadSnapshot(path) == 1, "undamaged copy");
+
+    // A snapshot that can not be written says why, the previous one stays
+    bool failed = false;
+    try {
+        store.writeSnapshot(dir + "/missing/store.snap");
+    } catch (const std::runtime_error& e) {
+        failed = std::string(e.what()).find("No such file or directory") != std::string::npos;
+    }
+    CHECK(failed, "write into a missing directory");
+}
+
+static void testBackgroundSnapshots(const std::string& dir) {
+    std::string path = dir + "/background.snap";
+    {
+        GraphStore store;
+        store.startSnapshots(path, 3600);
+        store.put("late", makeEntry(Graph(4), "prim"));
+        // Stopping writes what was stored since the last snapshot, without waiting for the interval
+        store.stopSnapshots();
+    }
+    GraphStore loaded;
+    loaded.startSnapshots(path, 3600);
+    CHECK(loaded.size() == 1 && loaded.get("late") != nullptr, loaded.size());
+    loaded.stopSnapshots();
+}
+
+static void testLoadCommandAndPrefork() {
+    std::string name;
+    CHECK(parseLoadCommand("load graph1", name) && name == "graph1", name);
+    CHECK(!parseLoadCommand("5", name) && !parseLoadCommand("loader", name), "not a load");
+    bool refused = false;
+    try {
+        parseLoadCommand("load", name);
+    } catch (const std::invalid_argument&) {
+        refused = true;
+    }
+    CHECK(refused, "load without a name");
+
+    // A worker of the prefork mode would keep graphs the other workers can not load
+    GraphStore store;
+    store.disable("Stored graphs are not available in prefork mode");
+    int refusals = 0;
+    try {
+        store.put("g", makeEntry(Graph(2), "prim"));
+    } catch (const std::logic_error&) {
+        ++refusals;
+    }
+    try {
+        store.get("g");
+    } catch (const std::logic_error&) {
+        ++refusals;
+    }
+    CHECK(refusals == 2 && store.size() == 0, refusals);
+
+    std::string args[] = {"server", "--workers=2", "--snapshot=graphs.snap"};
+    char* argv[] = {&args[0][0], &args[1][0], &args[2][0]};
+    refused = false;
+    try {
+        parseServerArgs(3, argv);
+    } catch (const std::invalid_argument&) {
+        refused = true;
+    }
+    CHECK(refused, "--snapshot with --workers");
+}
+
+int main() {
+    char dirTemplate[] = "/tmp/graph_store_test.XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        std::cerr << "mkdtemp failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::string dir = dirTemplate;
+
+    testRoundTrip(dir);
+    testDamagedSnapshots(dir);
+    testBackgroundSnapshots(dir);
+    testLoadCommandAndPrefork();
+
+    const char* const files[] = {"store.snap", "again.snap", "damaged.snap", "good.snap", "background.snap"};
+    for (const char* file : files) std::remove((dir + "/" + file).c_str());
+    rmdir(dir.c_str());
+    return finishTests("graph_store_test");
+}
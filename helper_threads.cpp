@@ -0,0 +1,30 @@
+#include "helper_threads.hpp"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+static std::mutex helperMutex;
+static unsigned helperLimit = 0; // 0 = hardware concurrency
+static unsigned helpersInUse = 0;
+
+// Helper: the budget, resolved on first use
+static unsigned limit() {
+    return helperLimit != 0 ? helperLimit : std::max(1u, std::thread::hardware_concurrency());
+}
+
+void setHelperThreadLimit(unsigned value) {
+    std::lock_guard<std::mutex> lock(helperMutex);
+    helperLimit = value;
+}
+
+HelperThreads::HelperThreads(unsigned wanted) {
+    std::lock_guard<std::mutex> lock(helperMutex);
+    unsigned total = limit();
+    granted = helpersInUse < total ? std::min(wanted, total - helpersInUse) : 0;
+    helpersInUse += granted;
+}
+
+HelperThreads::~HelperThreads() {
+    std::lock_guard<std::mutex> lock(helperMutex);
+    helpersInUse -= granted;
+}
@@ -0,0 +1,29 @@
+#ifndef HELPER_THREADS_HPP
+#define HELPER_THREADS_HPP
+
+// Threads started by the parallel parts of the requests (batch queries, generated graphs, estimates, the
+// "race" algorithm). They come from one budget shared by all the requests of the process, so the number of
+// threads does not grow with the number of clients: a request that finds the budget spent runs on its own thread.
+
+// Sets the budget, 0 = the hardware concurrency (the default)
+void setHelperThreadLimit(unsigned limit);
+
+/**
+ * Class: HelperThreads
+ * Lease of up to `wanted` threads of the budget, returned when the lease is destroyed.
+ */
+class HelperThreads {
+public:
+    explicit HelperThreads(unsigned wanted);
+    ~HelperThreads();
+    HelperThreads(const HelperThreads&) = delete;
+    HelperThreads& operator=(const HelperThreads&) = delete;
+
+    // Threads the caller may start besides its own, possibly 0
+    unsigned count() const { return granted; }
+
+private:
+    unsigned granted;
+};
+
+#endif // HELPER_THREADS_HPP
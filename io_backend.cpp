@@ -0,0 +1,507 @@
+#include "io_backend.hpp"
+#include "client_session.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#define FIXED_BUFFER_COUNT 64   // Number of registered buffers for the edge-upload path
+#define FIXED_BUFFER_SIZE 4096  // Size of every registered buffer
+#define RING_ENTRIES 256        // Submission queue size of the io_uring
+#define EPOLL_EVENTS 64         // Events handled per epoll_wait call
+
+namespace {
+
+// State of one client while it uploads its graph
+struct Connection {
+    int fd;
+    ClientSession session;
+    std::string pending; // output not yet sent
+    size_t sent = 0;     // bytes of pending already sent
+    int bufferSlot = -1; // registered buffer used for reads (io_uring only)
+    std::vector<char> buffer;
+
+    Connection(int socket, const ClientLimits& limits) : fd(socket), session(limits) {
+        pending = session.takeOutput();
+    }
+};
+
+// What a connection is waiting for next
+enum class Step { Read, Write, HandOff, Close };
+
+Step nextStep(const Connection& conn) {
+    if (conn.sent < conn.pending.size()) {
+        return Step::Write;
+    }
+    if (conn.session.isReady()) {
+        return Step::HandOff;
+    }
+    if (conn.session.isFailed()) {
+        return Step::Close;
+    }
+    return Step::Read;
+}
+
+// Passes bytes received from the client to its session and queues the answer
+void receive(Connection& conn, const char* data, size_t len) {
+    TRACE_SCOPE("receive");
+    if (conn.sent == conn.pending.size()) {
+        conn.pending.clear();
+        conn.sent = 0;
+    }
+    conn.session.feed(data, len);
+    conn.pending += conn.session.takeOutput();
+}
+
+void setBlocking(int fd, bool blocking) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        return;
+    }
+    fcntl(fd, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+}
+
+/**
+ * Class: EpollBackend
+ * Readiness based event loop, every socket is non-blocking and registered for the
+ * event (read or write) its session is waiting for.
+ */
+class EpollBackend : public IoBackend {
+public:
+    explicit EpollBackend(const ServerConfig& config) : config(config) {}
+
+    void run(int serverFd, const ReadyHandler& onReady) override {
+        epollFd = epoll_create1(0);
+        if (epollFd < 0) {
+            std::cerr << "epoll_create1 failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        setBlocking(serverFd, false);
+        watch(serverFd, EPOLLIN, EPOLL_CTL_ADD);
+
+        std::vector<epoll_event> events(EPOLL_EVENTS);
+        while (true) {
+            int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == serverFd) {
+                    acceptClients(serverFd, onReady);
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                Connection& conn = *it->second;
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !readAvailable(conn)) {
+                    closeConnection(conn);
+                    continue;
+                }
+                drive(conn, onReady);
+            }
+        }
+        close(epollFd);
+    }
+
+    std::string name() const override {
+        return "epoll";
+    }
+
+private:
+    ServerConfig config;
+    int epollFd = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::unordered_map<int, uint32_t> interest; // events each socket is registered for
+
+    void watch(int fd, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, op, fd, &ev);
+        interest[fd] = events;
+    }
+
+    void acceptClients(int serverFd, const ReadyHandler& onReady) {
+        while (true) {
+            int fd = accept4(serverFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+                }
+                return;
+            }
+            if (connections.size() >= config.maxClients) {
+                // Load shedding: too many uploads in progress
+                send(fd, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_NOSIGNAL);
+                close(fd);
+                continue;
+            }
+            std::cout << "Client connected! (epoll)" << std::endl;
+            Connection& conn = *(connections[fd] = std::make_unique<Connection>(fd, config.limits));
+            watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+            drive(conn, onReady);
+        }
+    }
+
+    // Reads everything the socket has, returns false when the client is gone
+    bool readAvailable(Connection& conn) {
+        char buffer[FIXED_BUFFER_SIZE];
+        while (true) {
+            ssize_t n = read(conn.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                receive(conn, buffer, static_cast<size_t>(n));
+                // Stop reading once the upload is complete, the rest belongs to the server
+                if (conn.session.isReady() || conn.session.isFailed()) return true;
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+    }
+
+    void drive(Connection& conn, const ReadyHandler& onReady) {
+        while (true) {
+            switch (nextStep(conn)) {
+                case Step::Write: {
+                    ssize_t n = send(conn.fd, conn.pending.data() + conn.sent, conn.pending.size() - conn.sent,
+                                     MSG_NOSIGNAL);
+                    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                        if (interest[conn.fd] != EPOLLOUT) watch(conn.fd, EPOLLOUT, EPOLL_CTL_MOD);
+                        return;
+                    }
+                    if (n < 0) {
+                        if (errno == EINTR) break;
+                        closeConnection(conn);
+                        return;
+                    }
+                    conn.sent += static_cast<size_t>(n);
+                    break;
+                }
+                case Step::Read:
+                    if (interest[conn.fd] != EPOLLIN) watch(conn.fd, EPOLLIN, EPOLL_CTL_MOD);
+                    return;
+                case Step::HandOff: {
+                    int fd = conn.fd;
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                    setBlocking(fd, true);
+                    Graph graph = conn.session.takeGraph();
+                    std::string algo = conn.session.getAlgorithm();
+                    std::string pending = conn.session.takeRemainingInput();
+                    std::shared_ptr<const StoredGraph> stored = conn.session.takeStoredGraph();
+                    interest.erase(fd);
+                    connections.erase(fd);
+                    onReady(fd, std::move(graph), algo, std::move(pending), std::move(stored));
+                    return;
+                }
+                case Step::Close:
+                    closeConnection(conn);
+                    return;
+            }
+        }
+    }
+
+    void closeConnection(Connection& conn) {
+        int fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        interest.erase(fd);
+        connections.erase(fd);
+    }
+};
+
+// Operation encoded in the low bits of the io_uring user_data
+enum UringOp : uint64_t { OP_ACCEPT = 0, OP_READ = 1, OP_WRITE = 2 };
+
+/**
+ * Class: UringBackend
+ * Completion based event loop on top of the raw io_uring system calls. Accepts, reads
+ * and sends are queued as submission entries and submitted in one batch per loop
+ * iteration, the completions drive the sessions. Reads of the (large) edge uploads use
+ * buffers registered once with the kernel, so they are not mapped on every request.
+ */
+class UringBackend : public IoBackend {
+public:
+    explicit UringBackend(const ServerConfig& config) : config(config) {}
+
+    ~UringBackend() override {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) close(ringFd);
+    }
+
+    // Creates the ring and registers the buffers, returns false if io_uring is not available
+    bool init() {
+        io_uring_params params{};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+        if (ringFd < 0) {
+            std::cerr << "io_uring_setup failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            return false;
+        }
+        cqRing = singleMmap ? sqRing
+                            : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                                   IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                             IORING_OFF_SQES);
+        if (sqesPtr == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqesPtr);
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        localTail = *sqTail;
+
+        // Register the buffers of the edge-upload path
+        fixedBuffers.resize(FIXED_BUFFER_COUNT * FIXED_BUFFER_SIZE);
+        std::vector<iovec> iovecs(FIXED_BUFFER_COUNT);
+        for (int i = 0; i < FIXED_BUFFER_COUNT; ++i) {
+            iovecs[i].iov_base = fixedBuffers.data() + i * FIXED_BUFFER_SIZE;
+            iovecs[i].iov_len = FIXED_BUFFER_SIZE;
+        }
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, iovecs.data(), FIXED_BUFFER_COUNT) == 0) {
+            for (int i = FIXED_BUFFER_COUNT - 1; i >= 0; --i) freeSlots.push_back(i);
+        } else {
+            std::cerr << "io_uring buffer registration failed, using plain reads: " << strerror(errno) << std::endl;
+        }
+        return true;
+    }
+
+    void run(int serverFd, const ReadyHandler& onReady) override {
+        submitAccept(serverFd);
+
+        std::vector<io_uring_cqe> completions;
+        while (true) {
+            // Submit everything queued since the last iteration and wait for at least one completion
+            __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+            int ret = static_cast<int>(
+                syscall(__NR_io_uring_enter, ringFd, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "io_uring_enter failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            unsubmitted -= static_cast<unsigned>(ret);
+
+            // Copy the completions out so the kernel can reuse the slots while they are handled
+            completions.clear();
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                completions.push_back(cqes[head & cqMask]);
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+            for (const auto& cqe : completions) {
+                handleCompletion(serverFd, cqe.user_data, cqe.res, onReady);
+            }
+        }
+    }
+
+    std::string name() const override {
+        return "uring";
+    }
+
+private:
+    ServerConfig config;
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned localTail = 0;  // tail including the entries not yet published to the kernel
+    unsigned unsubmitted = 0; // entries published but not yet consumed by io_uring_enter
+
+    std::vector<char> fixedBuffers;
+    std::vector<int> freeSlots;
+    uint64_t nextId = 1;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;
+
+    io_uring_sqe* getSqe() {
+        // Submit the queued entries if the ring is full
+        while (localTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+            __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, unsubmitted, 0, 0, nullptr, 0));
+            if (ret > 0) unsubmitted -= static_cast<unsigned>(ret);
+        }
+        unsigned index = localTail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        ++localTail;
+        ++unsubmitted;
+        return sqe;
+    }
+
+    void submitAccept(int serverFd) {
+        io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = serverFd;
+        sqe->user_data = OP_ACCEPT;
+    }
+
+    void submitRead(uint64_t id, Connection& conn) {
+        io_uring_sqe* sqe = getSqe();
+        sqe->fd = conn.fd;
+        sqe->user_data = (id << 2) | OP_READ;
+        if (conn.bufferSlot >= 0) {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(fixedBuffers.data() + conn.bufferSlot * FIXED_BUFFER_SIZE);
+            sqe->len = FIXED_BUFFER_SIZE;
+            sqe->buf_index = static_cast<uint16_t>(conn.bufferSlot);
+        } else {
+            conn.buffer.resize(FIXED_BUFFER_SIZE);
+            sqe->opcode = IORING_OP_RECV;
+            sqe->addr = reinterpret_cast<uint64_t>(conn.buffer.data());
+            sqe->len = FIXED_BUFFER_SIZE;
+        }
+    }
+
+    void submitWrite(uint64_t id, Connection& conn) {
+        io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = conn.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(conn.pending.data() + conn.sent);
+        sqe->len = static_cast<uint32_t>(conn.pending.size() - conn.sent);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = (id << 2) | OP_WRITE;
+    }
+
+    void handleCompletion(int serverFd, uint64_t userData, int res, const ReadyHandler& onReady) {
+        uint64_t op = userData & 3;
+        if (op == OP_ACCEPT) {
+            if (res >= 0 && connections.size() >= config.maxClients) {
+                // Load shedding: too many uploads in progress
+                send(res, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+                close(res);
+            } else if (res >= 0) {
+                std::cout << "Client connected! (uring)" << std::endl;
+                uint64_t id = nextId++;
+                Connection& conn = *(connections[id] = std::make_unique<Connection>(res, config.limits));
+                if (!freeSlots.empty()) {
+                    conn.bufferSlot = freeSlots.back();
+                    freeSlots.pop_back();
+                }
+                drive(id, conn, onReady);
+            } else {
+                std::cerr << "Accept failed: " << strerror(-res) << std::endl;
+            }
+            submitAccept(serverFd);
+            return;
+        }
+
+        uint64_t id = userData >> 2;
+        auto it = connections.find(id);
+        if (it == connections.end()) return;
+        Connection& conn = *it->second;
+
+        if (res <= 0) {
+            // The client closed the connection or the operation failed
+            closeConnection(id, conn, true);
+            return;
+        }
+        if (op == OP_READ) {
+            const char* data = conn.bufferSlot >= 0 ? fixedBuffers.data() + conn.bufferSlot * FIXED_BUFFER_SIZE
+                                                    : conn.buffer.data();
+            receive(conn, data, static_cast<size_t>(res));
+        } else {
+            conn.sent += static_cast<size_t>(res);
+        }
+        drive(id, conn, onReady);
+    }
+
+    void drive(uint64_t id, Connection& conn, const ReadyHandler& onReady) {
+        switch (nextStep(conn)) {
+            case Step::Write:
+                submitWrite(id, conn);
+                break;
+            case Step::Read:
+                submitRead(id, conn);
+                break;
+            case Step::HandOff: {
+                int fd = conn.fd;
+                Graph graph = conn.session.takeGraph();
+                std::string algo = conn.session.getAlgorithm();
+                std::string pending = conn.session.takeRemainingInput();
+                std::shared_ptr<const StoredGraph> stored = conn.session.takeStoredGraph();
+                closeConnection(id, conn, false);
+                onReady(fd, std::move(graph), algo, std::move(pending), std::move(stored));
+                break;
+            }
+            case Step::Close:
+                closeConnection(id, conn, true);
+                break;
+        }
+    }
+
+    void closeConnection(uint64_t id, Connection& conn, bool closeSocket) {
+        if (conn.bufferSlot >= 0) freeSlots.push_back(conn.bufferSlot);
+        if (closeSocket) close(conn.fd);
+        connections.erase(id);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<IoBackend> makeIoBackend(const ServerConfig& config) {
+    if (config.io == IoBackendKind::Uring) {
+        auto uring = std::make_unique<UringBackend>(config);
+        if (uring->init()) {
+            return uring;
+        }
+        std::cerr << "io_uring is not available, falling back to epoll" << std::endl;
+    }
+    return std::make_unique<EpollBackend>(config);
+}
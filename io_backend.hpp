@@ -0,0 +1,38 @@
+#ifndef IO_BACKEND_HPP
+#define IO_BACKEND_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "graph.hpp"
+#include "graph_store.hpp"
+#include "server_config.hpp"
+
+/**
+ * Class: IoBackend
+ * Asynchronous accept/read/send loop shared by both servers. A single thread accepts the
+ * clients and drives a ClientSession per connection until the graph and the MST algorithm
+ * were uploaded. The connection is then handed to the server (in blocking mode) through the
+ * ReadyHandler, which computes the MST and the analysis on its own threads.
+ */
+class IoBackend {
+public:
+    // Called with a blocking socket, the uploaded graph, the requested algorithm
+    // and the bytes the client already sent after the algorithm.
+    // If the client loaded a stored graph, stored is set instead of the graph and the algorithm.
+    using ReadyHandler = std::function<void(int socket, Graph graph, const std::string& algo, std::string pending,
+                                            std::shared_ptr<const StoredGraph> stored)>;
+
+    virtual ~IoBackend() = default;
+
+    // Runs the event loop on the listening socket, returns only on a fatal error
+    virtual void run(int serverFd, const ReadyHandler& onReady) = 0;
+
+    virtual std::string name() const = 0;
+};
+
+// Factory: creates the backend selected by config.io, with the admission limits of config.
+// io_uring falls back to epoll when the kernel does not allow it.
+std::unique_ptr<IoBackend> makeIoBackend(const ServerConfig& config);
+
+#endif // IO_BACKEND_HPP
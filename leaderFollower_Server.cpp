@@ -8,20 +8,36 @@
 #include <netinet/in.h>
 #include <unistd.h>
 #include <sstream>
+#include <cstring>
 #include <functional>
+#include <stdexcept>
 #include "graph.hpp"
+#include "graph_generator.hpp"
+#include "graph_store.hpp"
+#include "helper_threads.hpp"
 #include "mst.hpp"
+#include "server_config.hpp"
+#include "io_backend.hpp"
+#include "line_reader.hpp"
+#include "client_commands.hpp"
+#include "output_buffer.hpp"
+#include "prefork.hpp"
+#include "trace.hpp"
 #include <csignal>
 
 #define PORT 8094
-#define THREAD_POOL_SIZE 4
 
 bool close_server = false;
 
 class LeaderFollowerServer {
 private:
     struct Task {
-        int newSocket;
+        int newSocket = -1;
+        bool uploaded = false; // true if an async I/O backend already received the graph and the algorithm
+        Graph graph{};
+        std::string algo{};
+        std::string pending{}; // bytes received by the backend after the algorithm
+        std::shared_ptr<const StoredGraph> stored{}; // set instead of the graph if the client loaded a stored graph
     };
 
     std::vector<std::thread> workers;      
@@ -29,68 +45,116 @@ private:
     std::mutex queueMutex;               
     std::condition_variable cv;         
     bool stopFlag;                      
+    ServerConfig config;                   // queue capacity and per-client limits
          
-    Graph build_graph(int newSocket)
+    // Reads the answer to a prompt, the prompts pending in out are flushed first
+    std::string read_answer(LineReader& reader)
     {
-        std::string response = "----------Graph creation----------\nEnter the number of vertices: ";
-        send(newSocket, response.c_str(), response.size(), 0);
+        std::string answer;
+        if (!reader.readLine(answer)) {
+            throw std::runtime_error("Client disconnected");
+        }
+        return answer;
+    }
+
+    // Builds the graph of the client, or sets stored (and returns an empty graph) if the client loaded a stored graph
+    Graph build_graph(LineReader& reader, OutputBuffer& out, int newSocket, std::shared_ptr<const StoredGraph>& stored)
+    {
+        TRACE_SCOPE_ID("build_graph", newSocket);
+        out.append("----------Graph creation----------\nEnter the number of vertices: ");
+        std::string answer = read_answer(reader);
+
+        // A stored graph comes with its MST, the algorithm is not asked
+        std::string name;
+        if (parseLoadCommand(answer, name))
+        {
+            stored = graphStore().get(name);
+            if (!stored) {
+                throw std::invalid_argument("No stored graph named " + name);
+            }
+            out.append(describeStoredGraph(name, *stored));
+            return Graph();
+        }
 
-        char answer[1024] = {0};
-        read(newSocket, answer, 1024);
-        int numVertices = std::stoi(answer);
+        // The graph can be generated by the server instead of uploaded
+        if (isGeneratorCommand(answer))
+        {
+            GeneratorSpec spec = parseGeneratorCommand(answer);
+            config.limits.checkVertices(spec.vertices);
+            Graph graph = generateGraph(spec);
+            out.append(describeGeneratedGraph(spec, graph) + "New graph created!\n");
+            return graph;
+        }
+
+        std::istringstream vertexStream(answer);
+        long numVertices = -1;
+        if (!(vertexStream >> numVertices)) {
+            throw std::invalid_argument("Invalid number of vertices");
+        }
+
+        // Reject a too large graph before its matrix is allocated
+        config.limits.checkVertices(numVertices);
 
         // Create a new graph with the given number of vertices
-        Graph graph = Graph(numVertices); 
+        Graph graph = Graph(static_cast<int>(numVertices)); 
 
-        response = "Enter the number of edges: ";
-        send(newSocket, response.c_str(), response.size(), 0);
+        out.append("Enter the number of edges: ");
 
-        answer[1024] = {0};
-        read(newSocket, answer, 1024);
-        int numEdges = std::stoi(answer);
+        // "<count> quiet": no prompt and no acknowledgement per edge, only a summary at the end
+        std::istringstream countStream(read_answer(reader));
+        long numEdges = -1;
+        std::string mode;
+        if (!(countStream >> numEdges)) {
+            throw std::invalid_argument("Invalid number of edges");
+        }
+        countStream >> mode;
+        bool quiet = mode == "quiet";
+        config.limits.checkEdges(numEdges);
 
         // Add edges to the graph
         for (int i = 0; i < numEdges; ++i)
         {
-            response = "Enter an edge (from, to, weight): ";
-            send(newSocket, response.c_str(), response.size(), 0);
+            if (!quiet) out.append("Enter an edge (from, to, weight): ");
 
             int from, to, weight;
-            char edgeBuffer[1024] = {0};
-            read(newSocket, edgeBuffer, 1024);
-            std::istringstream edgeStream(edgeBuffer);
-            edgeStream >> from >> to >> weight;
+            std::string edge = read_answer(reader);
+            std::istringstream edgeStream(edge);
+            if (!(edgeStream >> from >> to >> weight)) {
+                throw std::invalid_argument("Invalid edge: " + edge);
+            }
             graph.addEdge(from, to, weight);
-            std::string response = "Edge from " + std::to_string(from) + " -> " + std::to_string(to) +" with weight " + std::to_string(weight) + " added successfully!\n";
-            send(newSocket, response.c_str(), response.size(), 0);
+            if (!quiet) {
+                out.append("Edge from " + std::to_string(from) + " -> " + std::to_string(to) + " with weight " +
+                           std::to_string(weight) + " added successfully!\n");
+            }
         }
-        response = "New graph created!\n";
-        send(newSocket, response.c_str(), response.size(), 0);
+        if (quiet) out.append(std::to_string(numEdges) + " edges added successfully!\n");
+        out.append("New graph created!\n");
 
         return graph;
     }
 
-    MST build_mst(Graph graph, int newSocket)
+    MST build_mst(const Graph& graph, LineReader& reader, OutputBuffer& out, int newSocket)
     {
-        std::string response = "----------MST creation----------\nEnter the algorithm of MST (prim or boruvka): ";
-        send(newSocket, response.c_str(), response.size(), 0);
-
-        char algoBuffer[1024] = {0};
-        read(newSocket, algoBuffer, 1024);
-        std::string algo(algoBuffer);
-
-        // Trim whitespace and newline characters
-        // algo.erase(algo.find_last_not_of(" \t\n\r") + 1);
+        out.append("----------MST creation----------\nEnter the algorithm of MST (prim, boruvka, auto or race): ");
+        std::string algo = read_answer(reader);
+        return create_mst(graph, algo, out, newSocket);
+    }
 
-        MST mst = MST(graph.getGraph(), graph.getVertexCount(), algo); // Create the MST
-        response = "MST created using " + algo + " algorithm\n";
-        send(newSocket, response.c_str(), response.size(), 0);
+    // Computes the MST with the given algorithm and reports it to the client
+    MST create_mst(const Graph& graph, const std::string& algo, OutputBuffer& out, int newSocket)
+    {
+        TRACE_SCOPE_ID("create_mst", newSocket);
+        MST mst = MST(graph, algo, config.reorder); // Create the MST on the narrowest weight/index types that fit the graph
+        std::cout << "MST computed on " << mst.getTypeName() << std::endl;
+        out.append(describeMSTCreation(mst));
 
         return mst;
     }
 
-    void analyze_data(MST mst, int newSocket)
+    void analyze_data(MST mst, OutputBuffer& out, int newSocket)
     {
+        TRACE_SCOPE_ID("analyze_data", newSocket);
         std::stringstream ss;
 
         ss << "----------analyze_data----------\n";
@@ -98,17 +162,64 @@ private:
         ss << "Longest Distance (e.g. 0->1):  " << mst.getLongestDistance(0, 1) << "\n";
         ss << "Shortest Distance (e.g. 0->1):  " << mst.getShortestDistance(0, 1) << "\n";
         ss << "Average Edge Count:  " << mst.getAverageEdgeCount() << "\n";
+        ss << "Components:  " << mst.getComponentCount() << "\n";
+
+        // Disconnected graph: the MST is a spanning forest, report every tree
+        if (mst.getComponentCount() > 1)
+        {
+            std::vector<int64_t> weights = mst.getTotalWeightPerComponent();
+            std::vector<double> averages = mst.getAverageEdgeCountPerComponent();
+            for (int c = 0; c < mst.getComponentCount(); ++c)
+            {
+                ss << "Component " << c << ":  Total Weight " << weights[c] << ", Average Edge Count " << averages[c] << "\n";
+            }
+        }
 
-        send(newSocket, (ss.str()).c_str(), (ss.str()).size(), 0);
+        out.append(ss.str());
     }
 
     void processClient(int newSocket) {
-        Graph graph = build_graph(newSocket);
-        MST mst = build_mst(newSocket, newSocket);
-        analyze_data(mst, newSocket);
+        TRACE_SCOPE_ID("processClient", newSocket);
+        OutputBuffer out(newSocket);
+        LineReader reader(newSocket, "", &out);
+        try {
+            std::shared_ptr<const StoredGraph> session;
+            Graph graph = build_graph(reader, out, newSocket, session);
+            if (!session) {
+                MST mst = build_mst(graph, reader, out, newSocket);
+                session = std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+            }
+            analyze_data(session->mst, out, newSocket);
+            serveCommands(session, config.limits, newSocket, reader, out);
+        } catch (const std::exception& e) {
+            // Invalid input or a graph above the limits, the worker keeps serving other clients
+            out.append(std::string("Error: ") + e.what() + "\n");
+        }
+        out.flush();
         close(newSocket);
     }
 
+    // Same as processClient for a client whose upload was handled by an async I/O backend
+    void processUploadedClient(Task& task) {
+        TRACE_SCOPE_ID("processUploadedClient", task.newSocket);
+        OutputBuffer out(task.newSocket);
+        LineReader reader(task.newSocket, std::move(task.pending), &out);
+        try {
+            std::shared_ptr<const StoredGraph> session = task.stored;
+            if (!session) {
+                MST mst = create_mst(task.graph, task.algo, out, task.newSocket);
+                session = std::make_shared<const StoredGraph>(StoredGraph{std::move(task.graph), mst});
+            }
+            analyze_data(session->mst, out, task.newSocket);
+            serveCommands(session, config.limits, task.newSocket, reader, out);
+        } catch (const std::exception& e) {
+            // Same as processClient: the error goes to the client, the worker keeps serving other clients
+            out.append(std::string("Error: ") + e.what() + "\n");
+        }
+        out.flush();
+        close(task.newSocket);
+    }
+
     void workerLoop() {
         while (true) {
             Task task;
@@ -116,15 +227,19 @@ private:
                 std::unique_lock<std::mutex> lock(queueMutex);
                 cv.wait(lock, [this]() { return !tasks.empty() || stopFlag; });
                 if (stopFlag && tasks.empty()) return;
-                task = tasks.front();
+                task = std::move(tasks.front());
                 tasks.pop();
             }
-            processClient(task.newSocket);
+            if (task.uploaded) {
+                processUploadedClient(task);
+            } else {
+                processClient(task.newSocket);
+            }
         }
     }
 
 public:
-    LeaderFollowerServer(size_t poolSize) : stopFlag(false) {                  
+    LeaderFollowerServer(size_t poolSize, const ServerConfig& config) : stopFlag(false), config(config) {
         // this for loop is for creating the threads
         for (size_t i = 0; i < poolSize; ++i) {
             // create a new thread and push it to the workers vector
@@ -144,21 +259,45 @@ public:
         }
     }
 
-    void addTask(int newSocket) {
+    // Returns false if the queue is full, the caller then sheds the client
+    bool addTask(int newSocket) {
         {
             std::unique_lock<std::mutex> lock(queueMutex);
+            if (tasks.size() >= config.queueCapacity) return false;
             tasks.push(Task{newSocket});
         }
         cv.notify_one();
+        return true;
+    }
+
+    // Adds a client whose graph and algorithm were already received
+    bool addUploadedTask(int newSocket, Graph graph, const std::string& algo, std::string pending,
+                         std::shared_ptr<const StoredGraph> stored) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (tasks.size() >= config.queueCapacity) return false;
+            tasks.push(Task{newSocket, true, std::move(graph), algo, std::move(pending), std::move(stored)});
+        }
+        cv.notify_one();
+        return true;
     }
 };
 
-int main() {
+// Runs one server: the listening socket, the thread pool and the accept loop
+// In prefork mode every worker process runs it on the same port
+int serve(const ServerConfig& config) {
     int serverFd, newSocket;
     struct sockaddr_in address;
     int addrlen = sizeof(address);
     int opt = 1;
 
+    // Trace spans of this process, dumped on SIGUSR1
+    if (config.trace) traceStart();
+    setHelperThreadLimit(config.helperThreads);
+
+    // Graphs stored before the restart, then a snapshot every interval
+    if (!config.snapshotPath.empty()) graphStore().startSnapshots(config.snapshotPath, config.snapshotInterval);
+
     if ((serverFd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
         std::cerr << "Socket creation failed\n";
         return -1;
@@ -170,9 +309,16 @@ int main() {
         return -1;
     }
 
+    // Prefork mode: every worker binds the port, the kernel spreads the connections between them
+    if (config.workers > 1 && setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) {
+        std::cerr << "setsockopt SO_REUSEPORT failed\n";
+        close(serverFd);
+        return -1;
+    }
+
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
+    address.sin_port = htons(config.port != 0 ? config.port : PORT);
 
     if (bind(serverFd, (struct sockaddr*)&address, sizeof(address)) < 0) {
         std::cerr << "Bind failed\n";
@@ -180,18 +326,37 @@ int main() {
         return -1;
     }
 
-    if (listen(serverFd, 3) < 0) {
+    if (listen(serverFd, config.backlog) < 0) {
         std::cerr << "Listen failed\n";
         close(serverFd);
         return -1;
     }
 
-    // Create the server with a thread pool size of 4
-    LeaderFollowerServer server(THREAD_POOL_SIZE);
+    // Create the server with a thread pool of --threads threads (4 by default)
+    LeaderFollowerServer server(static_cast<size_t>(config.threads), config);
     std::cout << "Server running...\n";
 
+    if (config.io != IoBackendKind::Blocking) {
+        // The backend receives the uploads, the thread pool computes the MSTs
+        std::unique_ptr<IoBackend> backend = makeIoBackend(config);
+        std::cout << "Using " << backend->name() << " I/O backend\n";
+        backend->run(serverFd, [&server](int socket, Graph graph, const std::string& algo, std::string pending,
+                                         std::shared_ptr<const StoredGraph> stored) {
+            if (!server.addUploadedTask(socket, std::move(graph), algo, std::move(pending), std::move(stored))) {
+                send(socket, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_NOSIGNAL);
+                close(socket);
+            }
+        });
+        close(serverFd);
+        return 0;
+    }
+
     while ((newSocket = accept(serverFd, (struct sockaddr*)&address, (socklen_t*)&addrlen)) >= 0) {
-        server.addTask(newSocket);
+        if (!server.addTask(newSocket)) {
+            // Load shedding: every worker is busy and the queue is full
+            send(newSocket, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_NOSIGNAL);
+            close(newSocket);
+        }
         if (close_server) {
             close(serverFd);
             return 0;
@@ -201,3 +366,23 @@ int main() {
     close(serverFd);
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    try {
+        config = parseServerArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n" << serverUsage(argv[0]) << "\n";
+        return -1;
+    }
+
+    if (config.workers > 1) {
+        std::cout << "Prefork mode with " << config.workers << " workers\n";
+        return runPrefork(config.workers, [&config](int) {
+            // A graph saved by one worker could not be loaded by a client accepted by another one
+            graphStore().disable("Stored graphs are not available in prefork mode");
+            return serve(config);
+        });
+    }
+    return serve(config);
+}
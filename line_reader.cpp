@@ -0,0 +1,54 @@
+#include "line_reader.hpp"
+#include <cerrno>
+#include <utility>
+#include <poll.h>
+#include <unistd.h>
+
+#define READ_CHUNK 65536 // Bytes requested from the socket per read
+
+LineReader::LineReader(int socket, std::string pending, OutputBuffer* output)
+    : socket(socket), buffer(std::move(pending)), position(0), output(output) {}
+
+bool LineReader::readLine(std::string& line) {
+    // The client is given up on for good
+    if (expired) return false;
+    size_t newline;
+    while ((newline = buffer.find('\n', position)) == std::string::npos) {
+        // Drop the consumed part before reading more
+        buffer.erase(0, position);
+        position = 0;
+
+        // The client only answers once it got the prompts
+        if (output) output->flush();
+
+        // A silent client must not hold the thread serving it forever
+        if (idleTimeout > 0) {
+            pollfd ready{socket, POLLIN, 0};
+            int events = poll(&ready, 1, static_cast<int>(idleTimeout * 1000));
+            if (events < 0 && errno == EINTR) continue;
+            if (events == 0) {
+                expired = true;
+                return false;
+            }
+        }
+
+        char chunk[READ_CHUNK];
+        ssize_t n = read(socket, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            // Last line without a newline
+            if (buffer.empty()) return false;
+            newline = buffer.size();
+            buffer += '\n';
+            break;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+
+    line.assign(buffer, position, newline - position);
+    position = newline + 1;
+
+    // Trim whitespace and newline characters
+    line.erase(line.find_last_not_of(" \t\n\r") + 1);
+    return true;
+}
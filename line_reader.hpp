@@ -0,0 +1,38 @@
+#ifndef LINE_READER_HPP
+#define LINE_READER_HPP
+
+#include <string>
+#include "output_buffer.hpp"
+
+/**
+ * Class: LineReader
+ * Buffered line reader on top of a blocking socket. A single read() may return many
+ * lines (for example a whole batch of queries), which are then handed out one by one
+ * without further system calls. The responses pending in the output buffer (if any)
+ * are flushed before the reader waits for the client. With an idle timeout the reader
+ * gives up on a client that stays silent longer than that.
+ */
+class LineReader {
+public:
+    // pending: bytes already received from the socket (e.g. by an async I/O backend)
+    explicit LineReader(int socket, std::string pending = "", OutputBuffer* output = nullptr);
+
+    // Reads the next line without the newline and trailing whitespace.
+    // Returns false when the client closed the connection or the idle timeout expired.
+    bool readLine(std::string& line);
+
+    // Longest wait for the client before every read, in seconds (0 = no limit)
+    void setIdleTimeout(unsigned seconds) { idleTimeout = seconds; }
+    // True once readLine returned false because the idle timeout expired
+    bool timedOut() const { return expired; }
+
+private:
+    int socket;
+    std::string buffer;
+    size_t position;
+    OutputBuffer* output;
+    unsigned idleTimeout = 0;
+    bool expired = false;
+};
+
+#endif // LINE_READER_HPP
@@ -1,46 +1,176 @@
 #include "mst.hpp"
 #include "prim.hpp"      // Include the Prim's algorithm header
 #include "boruvka.hpp"    // Include the Boruvka's algorithm header
+#include "dsu.hpp"
+#include "helper_threads.hpp"
+#include "trace.hpp"
 #include <limits>
 #include <queue>
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept> // For exceptions
+#include <thread>
+
+// Measured with mst_benchmark: Borůvka is 1.3 to 3 times faster below AUTO_DENSE_DENSITY, whatever the size
+// and the weights (its compaction drops most of the edges after the first rounds). On near-complete graphs the
+// two are within a few percent, Prim being ahead only with int32_t weights.
+MSTChoice chooseMSTAlgorithm(uint64_t vertices, uint64_t edges, int64_t maxWeight) {
+    double density = vertices > 1 ? 2.0 * edges / (static_cast<double>(vertices) * (vertices - 1)) : 0;
+    std::ostringstream reason;
+    reason << std::fixed << std::setprecision(3) << "density " << density;
+    if (density < AUTO_DENSE_DENSITY) {
+        reason << " below " << AUTO_DENSE_DENSITY;
+        return {"boruvka", reason.str()};
+    }
+    if (maxWeight >= AUTO_PRIM_MIN_WEIGHT) {
+        reason << ", weights up to " << maxWeight;
+        return {"prim", reason.str()};
+    }
+    reason << ", weights below " << AUTO_PRIM_MIN_WEIGHT;
+    return {"boruvka", reason.str()};
+}
+
+void checkMSTAlgorithm(const std::string& algo) {
+    if (algo != "prim" && algo != "boruvka" && algo != "auto" && algo != "race") {
+        throw std::invalid_argument("Unknown MST algorithm: " + algo + " (prim, boruvka, auto or race)");
+    }
+}
 
 // Constructor
-MST::MST(const std::vector<std::vector<int>>& graph, int n, const std::string& algo) : graph(graph), numVertices(n) 
+template <typename W, typename I>
+BasicMST<W, I>::BasicMST(std::vector<std::vector<W>> graph, I n, const std::string& algo, std::vector<I> internalOf)
+    : numVertices(n), graph(std::move(graph)), internalOf(std::move(internalOf))
 {
+    checkMSTAlgorithm(algo);
     if (algo == "prim") {
         calculateMSTUsingPrim();
     } else if (algo == "boruvka") {
         calculateMSTUsingBoruvka();
+    } else if (algo == "auto") {
+        calculateMSTAutomatically();
+    } else {
+        calculateMSTByRace();
     }
 }
 
 // Function to calculate MST using Prim's algorithm
-void MST::calculateMSTUsingPrim() {
+template <typename W, typename I>
+void BasicMST<W, I>::calculateMSTUsingPrim() {
+    TRACE_SCOPE("prim");
     mstEdges = prim(convertGraphToEdges(), numVertices);
+    algorithm = "prim";
+    selectionReason.clear();
+    componentOf.clear();
 }
 
 // Public function to retrieve MST edges using Prim's algorithm
-std::vector<std::tuple<int, int, int, int>> MST::primMST() {
+template <typename W, typename I>
+std::vector<typename BasicMST<W, I>::Edge> BasicMST<W, I>::primMST() {
     calculateMSTUsingPrim();
     return mstEdges;
 }
 
 // Function to calculate MST using Boruvka's algorithm
-void MST::calculateMSTUsingBoruvka() {
+template <typename W, typename I>
+void BasicMST<W, I>::calculateMSTUsingBoruvka() {
+    TRACE_SCOPE("boruvka");
     mstEdges = boruvka(convertGraphToEdges(), numVertices);
+    algorithm = "boruvka";
+    selectionReason.clear();
+    componentOf.clear();
+}
+
+// Function to calculate MST with the algorithm chooseMSTAlgorithm picks for the graph
+template <typename W, typename I>
+void BasicMST<W, I>::calculateMSTAutomatically() {
+    std::vector<Edge> edges = convertGraphToEdges();
+    W maxWeight = 0;
+    for (const auto& edge : edges) {
+        maxWeight = std::max(maxWeight, std::get<2>(edge));
+    }
+    MSTChoice choice = chooseMSTAlgorithm(numVertices, edges.size(), static_cast<int64_t>(maxWeight));
+
+    if (choice.algorithm == "prim") {
+        TRACE_SCOPE("prim");
+        mstEdges = prim(edges, numVertices);
+    } else {
+        TRACE_SCOPE("boruvka");
+        mstEdges = boruvka(edges, numVertices);
+    }
+    algorithm = choice.algorithm;
+    selectionReason = "auto: " + choice.reason;
+    componentOf.clear();
+}
+
+// Function to calculate MST by running Prim and Borůvka at the same time on the same edges:
+// the first one to finish cancels the other one, which stops at its next check and returns nothing
+template <typename W, typename I>
+void BasicMST<W, I>::calculateMSTByRace() {
+    TRACE_SCOPE("race");
+    // Without a helper thread there is nothing to race, the algorithm is picked as by "auto"
+    HelperThreads helper(1);
+    if (helper.count() == 0) {
+        calculateMSTAutomatically();
+        selectionReason = "race: no helper thread available, " + selectionReason;
+        return;
+    }
+    const std::vector<Edge> edges = convertGraphToEdges();
+    std::atomic<bool> cancelPrim(false), cancelBoruvka(false);
+    std::atomic<int> winner(-1); // 0 = prim, 1 = boruvka
+    std::vector<Edge> primTree, boruvkaTree;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> winnerTime(0);
+
+    // A runner that was not cancelled has a complete tree, only the first one to get here wins
+    auto finish = [&](int runner, std::atomic<bool>& cancelOther) {
+        int none = -1;
+        if (winner.compare_exchange_strong(none, runner)) {
+            winnerTime = std::chrono::steady_clock::now() - start;
+            cancelOther.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::thread primRunner([&]() {
+        TRACE_SCOPE("prim");
+        primTree = prim(edges, numVertices, &cancelPrim);
+        if (!cancelPrim.load()) finish(0, cancelBoruvka);
+    });
+    {
+        TRACE_SCOPE("boruvka");
+        boruvkaTree = boruvka(edges, numVertices, &cancelBoruvka);
+        if (!cancelBoruvka.load()) finish(1, cancelPrim);
+    }
+    primRunner.join();
+
+    bool primWon = winner.load() == 0;
+    mstEdges = primWon ? std::move(primTree) : std::move(boruvkaTree);
+    algorithm = primWon ? "prim" : "boruvka";
+    std::ostringstream reason;
+    reason << std::fixed << std::setprecision(2) << "race: " << algorithm << " finished first in "
+           << winnerTime.count() << " ms, " << (primWon ? "boruvka" : "prim") << " was cancelled";
+    selectionReason = reason.str();
+    componentOf.clear();
 }
 
 // Public function to retrieve MST edges using Boruvka's algorithm
-std::vector<std::tuple<int, int, int, int>> MST::boruvkaMST() {
+template <typename W, typename I>
+std::vector<typename BasicMST<W, I>::Edge> BasicMST<W, I>::boruvkaMST() {
     calculateMSTUsingBoruvka();
     return mstEdges;
 }
 
 // Function to get the total weight of the MST
-int MST::getTotalWeight() {
-    int totalWeight = 0;
+template <typename W, typename I>
+typename BasicMST<W, I>::Sum BasicMST<W, I>::getTotalWeight() {
+    Sum totalWeight = 0;
     //the loop is to calculate the total weight of the MST
     // it goes through all the edges in the MST and adds their weight
     for (const auto& edge : mstEdges) {
@@ -50,58 +180,102 @@ int MST::getTotalWeight() {
 }
 
 // Helper function to convert graph representation to edges
-std::vector<std::tuple<int, int, int, int>> MST::convertGraphToEdges() {
-    std::vector<std::tuple<int, int, int, int>> edges;
-    for (int u = 0; u < numVertices; ++u) {
-        for (int v = u + 1; v < numVertices; ++v) { // Avoid duplicate edges
+template <typename W, typename I>
+std::vector<typename BasicMST<W, I>::Edge> BasicMST<W, I>::convertGraphToEdges() {
+    TRACE_SCOPE("convertGraphToEdges");
+    std::vector<Edge> edges;
+    if (!internalOf.empty()) {
+        // Relabelled graph: the same edges in the order of the client vertices
+        for (I u = 0; u < numVertices; ++u) {
+            const std::vector<W>& row = graph[internalOf[u]];
+            for (I v = u + 1; v < numVertices; ++v) {
+                if (row[internalOf[v]] > 0) {
+                    edges.emplace_back(internalOf[u], internalOf[v], row[internalOf[v]], static_cast<I>(edges.size()));
+                }
+            }
+        }
+        return edges;
+    }
+    for (I u = 0; u < numVertices; ++u) {
+        for (I v = u + 1; v < numVertices; ++v) { // Avoid duplicate edges
             if (graph[u][v] > 0) { // Only consider edges with positive weight
-                edges.emplace_back(u, v, graph[u][v], edges.size());
+                edges.emplace_back(u, v, graph[u][v], static_cast<I>(edges.size()));
             }
         }
     }
     return edges;
 }
 
-// Function to find the longest distance between two vertices u and v in the MST
-int MST::getLongestDistance(int u, int v) {
-    // Initialize the distance vector with negative infinity
-    std::vector<int> dist(numVertices, -std::numeric_limits<int>::max());
-    std::queue<int> q;
-    dist[u] = 0;
-    q.push(u);
-
-    while (!q.empty()) {
-        int current = q.front();
-        q.pop();
-        
-        // Iterate over the neighbors of the current vertex
-        // Update the distance if the new distance is greater
-        // than the current distance
-        for (int neighbor = 0; neighbor < numVertices; ++neighbor) {
-            if (graph[current][neighbor] > 0 && dist[neighbor] == -std::numeric_limits<int>::max()) {
-                dist[neighbor] = dist[current] + graph[current][neighbor];
-                q.push(neighbor);
+// Function to find the longest distance between two vertices u and v in the MST:
+// the weight of the tree path between them
+template <typename W, typename I>
+typename BasicMST<W, I>::Sum BasicMST<W, I>::getLongestDistance(I u, I v) {
+    if (u >= numVertices || v >= numVertices) {
+        return -1;
+    }
+    if (componentOf.size() != numVertices) computeComponents();
+    TreePaths paths = treePathsFrom(u);
+    return paths.weight[v] == std::numeric_limits<Sum>::max() ? -1 : paths.weight[v];
+}
+
+// Function to find the heaviest edge on the tree path between two vertices u and v
+template <typename W, typename I>
+typename BasicMST<W, I>::Sum BasicMST<W, I>::getBottleneckDistance(I u, I v) {
+    if (u >= numVertices || v >= numVertices) {
+        return -1;
+    }
+    if (componentOf.size() != numVertices) computeComponents();
+    TreePaths paths = treePathsFrom(u);
+    return paths.weight[v] == std::numeric_limits<Sum>::max() ? -1 : paths.heaviest[v];
+}
+
+// Function to calculate the average edge count in all paths between two vertices u and v
+template <typename W, typename I>
+double BasicMST<W, I>::getAverageEdgeCount() {
+    if (analytics.averageEdgeCount >= 0) return analytics.averageEdgeCount;
+    TRACE_SCOPE("getAverageEdgeCount");
+    const Sum INF = std::numeric_limits<Sum>::max();
+    Sum totalDistance = 0;
+    long long pairCount = 0;
+
+    std::vector<std::vector<Sum>> shortestPaths = allPairsShortestPaths();
+
+    // Calculate the total distance and pair count
+    for (I i = 0; i < numVertices; ++i) {
+        for (I j = i + 1; j < numVertices; ++j) {
+            if (shortestPaths[i][j] < INF) {
+                totalDistance += shortestPaths[i][j];
+                ++pairCount;
             }
         }
     }
 
-    return dist[v] == -std::numeric_limits<int>::max() ? -1 : dist[v];
+    // Return the average distance
+    analytics.averageEdgeCount = pairCount > 0 ? static_cast<double>(totalDistance) / pairCount : 0.0;
+    return analytics.averageEdgeCount;
 }
 
-// Function to calculate the average edge count in all paths between two vertices u and v
-double MST::getAverageEdgeCount() {
-    // Initialize the total distance and pair count
-    const int INF = std::numeric_limits<int>::max();
-    int totalDistance = 0;
-    int pairCount = 0;
-
-    // Initialize the shortest paths matrix
-    // implemented using Floyd-Warshall algorithm
-    std::vector<std::vector<int>> shortestPaths = graph;
-
-    for (int k = 0; k < numVertices; ++k) {
-        for (int i = 0; i < numVertices; ++i) {
-            for (int j = 0; j < numVertices; ++j) {
+// Helper function: shortest paths between all the pairs of vertices
+// implemented using Floyd-Warshall algorithm
+template <typename W, typename I>
+std::vector<std::vector<typename BasicMST<W, I>::Sum>> BasicMST<W, I>::allPairsShortestPaths() const {
+    TRACE_SCOPE("allPairsShortestPaths");
+    const Sum INF = std::numeric_limits<Sum>::max();
+
+    // Initialize the shortest paths matrix, a weight of 0 means there is no edge
+    std::vector<std::vector<Sum>> shortestPaths(numVertices);
+    for (I i = 0; i < numVertices; ++i) {
+        shortestPaths[i].assign(graph[i].begin(), graph[i].end());
+        for (I j = 0; j < numVertices; ++j) {
+            if (i != j && shortestPaths[i][j] == 0) {
+                shortestPaths[i][j] = INF;
+            }
+        }
+    }
+
+    for (I k = 0; k < numVertices; ++k) {
+        for (I i = 0; i < numVertices; ++i) {
+            for (I j = 0; j < numVertices; ++j) {
                 if (shortestPaths[i][k] < INF && shortestPaths[k][j] < INF) {
                     shortestPaths[i][j] = std::min(shortestPaths[i][j], shortestPaths[i][k] + shortestPaths[k][j]);
                 }
@@ -109,41 +283,734 @@ double MST::getAverageEdgeCount() {
         }
     }
 
-    // Calculate the total distance and pair count
-    for (int i = 0; i < numVertices; ++i) {
-        for (int j = i + 1; j < numVertices; ++j) {
+    return shortestPaths;
+}
+
+// Helper function: labels the connected components of the spanning forest
+template <typename W, typename I>
+void BasicMST<W, I>::computeComponents() {
+    TRACE_SCOPE("computeComponents");
+    const I NONE = std::numeric_limits<I>::max();
+    DSU<I> dsu(numVertices);
+    for (const auto& edge : mstEdges) {
+        dsu.unite(std::get<0>(edge), std::get<1>(edge));
+    }
+
+    // Number the components in the order of their smallest vertex
+    componentOf.assign(numVertices, NONE);
+    std::vector<I> rootComponent(numVertices, NONE);
+    componentCount = 0;
+    for (I v = 0; v < numVertices; ++v) {
+        I root = dsu.find(v);
+        if (rootComponent[root] == NONE) {
+            rootComponent[root] = componentCount++;
+        }
+        componentOf[v] = rootComponent[root];
+    }
+
+    // Neighbours of every vertex in the tree, packed: the ones of v are at [treeStart[v], treeStart[v + 1])
+    treeStart.assign(numVertices + 1, 0);
+    for (const auto& edge : mstEdges) {
+        ++treeStart[std::get<0>(edge) + 1];
+        ++treeStart[std::get<1>(edge) + 1];
+    }
+    std::partial_sum(treeStart.begin(), treeStart.end(), treeStart.begin());
+    treeNeighbours.resize(2 * mstEdges.size());
+    std::vector<I> next(treeStart.begin(), treeStart.end() - 1);
+    for (const auto& edge : mstEdges) {
+        treeNeighbours[next[std::get<0>(edge)]++] = {std::get<1>(edge), std::get<2>(edge)};
+        treeNeighbours[next[std::get<1>(edge)]++] = {std::get<0>(edge), std::get<2>(edge)};
+    }
+}
+
+template <typename W, typename I>
+I BasicMST<W, I>::getComponentCount() {
+    if (componentOf.size() != numVertices) computeComponents();
+    return componentCount;
+}
+
+template <typename W, typename I>
+I BasicMST<W, I>::getComponent(I v) {
+    if (componentOf.size() != numVertices) computeComponents();
+    return v >= numVertices ? std::numeric_limits<I>::max() : componentOf[v];
+}
+
+template <typename W, typename I>
+std::vector<std::vector<typename BasicMST<W, I>::Edge>> BasicMST<W, I>::getComponentTrees() {
+    std::vector<std::vector<Edge>> trees(getComponentCount());
+    for (const auto& edge : mstEdges) {
+        trees[componentOf[std::get<0>(edge)]].push_back(edge);
+    }
+    return trees;
+}
+
+template <typename W, typename I>
+std::vector<typename BasicMST<W, I>::Sum> BasicMST<W, I>::getTotalWeightPerComponent() {
+    std::vector<Sum> weights(getComponentCount(), 0);
+    for (const auto& edge : mstEdges) {
+        weights[componentOf[std::get<0>(edge)]] += std::get<2>(edge);
+    }
+    return weights;
+}
+
+template <typename W, typename I>
+std::vector<double> BasicMST<W, I>::getAverageEdgeCountPerComponent() {
+    I count = getComponentCount();
+    if (!analytics.averageEdgeCountPerComponent.empty() || count == 0) return analytics.averageEdgeCountPerComponent;
+    // A single component is the whole graph, its average is already known
+    if (count == 1) {
+        analytics.averageEdgeCountPerComponent.assign(1, getAverageEdgeCount());
+        return analytics.averageEdgeCountPerComponent;
+    }
+    TRACE_SCOPE("getAverageEdgeCountPerComponent");
+    const Sum INF = std::numeric_limits<Sum>::max();
+    std::vector<Sum> totalDistance(count, 0);
+    std::vector<long long> pairCount(count, 0);
+
+    // Pairs in different components are unreachable, so only pairs inside a component are counted
+    std::vector<std::vector<Sum>> shortestPaths = allPairsShortestPaths();
+    for (I i = 0; i < numVertices; ++i) {
+        for (I j = i + 1; j < numVertices; ++j) {
             if (shortestPaths[i][j] < INF) {
-                totalDistance += shortestPaths[i][j];
-                ++pairCount;
+                totalDistance[componentOf[i]] += shortestPaths[i][j];
+                ++pairCount[componentOf[i]];
             }
         }
     }
 
-    // Return the average distance
-    return pairCount > 0 ? static_cast<double>(totalDistance) / pairCount : 0.0;
+    std::vector<double> averages(count, 0.0);
+    for (I c = 0; c < count; ++c) {
+        if (pairCount[c] > 0) averages[c] = static_cast<double>(totalDistance[c]) / pairCount[c];
+    }
+    analytics.averageEdgeCountPerComponent = averages;
+    return averages;
 }
 
+// Function to find the shortest distance between two vertices u and v in the MST,
+// the tree path is the only path so it is the same as the longest distance
+template <typename W, typename I>
+typename BasicMST<W, I>::Sum BasicMST<W, I>::getShortestDistance(I u, I v) {
+    return getLongestDistance(u, v);
+}
 
-// Function to find the shortest distance between two vertices u and v in the MST
-// implemented using BFS
-int MST::getShortestDistance(int u, int v) {
-    std::vector<int> dist(numVertices, std::numeric_limits<int>::max());
-    std::queue<int> q;
+// Function to find the shortest distance between two vertices u and v in the graph
+// (the same distances as the average and the diameter)
+template <typename W, typename I>
+typename BasicMST<W, I>::Sum BasicMST<W, I>::getGraphDistance(I u, I v) {
+    if (u >= numVertices || v >= numVertices) {
+        return -1;
+    }
+    std::vector<Sum> dist = shortestDistancesFrom(u);
+    return dist[v] == std::numeric_limits<Sum>::max() ? -1 : dist[v];
+}
+
+// Helper function: walks the tree of u, the path to every vertex of its component is unique
+// (the components and the tree adjacency must have been computed, see batchQuery)
+template <typename W, typename I>
+typename BasicMST<W, I>::TreePaths BasicMST<W, I>::treePathsFrom(I u) const {
+    TreePaths paths;
+    paths.weight.assign(numVertices, std::numeric_limits<Sum>::max());
+    paths.heaviest.assign(numVertices, 0);
+
+    std::vector<I> stack{u};
+    paths.weight[u] = 0;
+    while (!stack.empty()) {
+        I current = stack.back();
+        stack.pop_back();
+        for (I e = treeStart[current]; e < treeStart[current + 1]; ++e) {
+            I next = treeNeighbours[e].first;
+            if (paths.weight[next] != std::numeric_limits<Sum>::max()) continue;
+            W weight = treeNeighbours[e].second;
+            paths.weight[next] = paths.weight[current] + weight;
+            paths.heaviest[next] = std::max<Sum>(paths.heaviest[current], weight);
+            stack.push_back(next);
+        }
+    }
+    return paths;
+}
+
+// Function to answer a batch of distance queries
+// Every distinct source is handled once: one walk of the tree for its queries on the MST,
+// one Dijkstra for its graph distance queries
+template <typename W, typename I>
+std::vector<typename BasicMST<W, I>::Sum> BasicMST<W, I>::batchQuery(const std::vector<DistanceQuery>& queries,
+                                                                   unsigned threads) {
+    TRACE_SCOPE("batchQuery");
+    std::vector<Sum> results(queries.size(), -1);
+
+    // Group the valid queries by their source vertex
+    std::vector<size_t> order;
+    order.reserve(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const DistanceQuery& q = queries[i];
+        if (q.u >= 0 && static_cast<uint64_t>(q.u) < numVertices && q.v >= 0 && static_cast<uint64_t>(q.v) < numVertices) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&queries](size_t a, size_t b) { return queries[a].u < queries[b].u; });
+
+    // groupStart[g] is the first index in order of the g-th source
+    std::vector<size_t> groupStart;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || queries[order[i]].u != queries[order[i - 1]].u) {
+            groupStart.push_back(i);
+        }
+    }
+    groupStart.push_back(order.size());
+    size_t groups = groupStart.size() - 1;
 
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, groups));
+    // The tree is built before the threads share it
+    if (componentOf.size() != numVertices) computeComponents();
+
+    // Every thread takes the next source that was not handled yet
+    // and writes only the results of that source's queries
+    std::atomic<size_t> nextGroup(0);
+    auto worker = [&]() {
+        size_t g;
+        while ((g = nextGroup.fetch_add(1)) < groups) {
+            I source = static_cast<I>(queries[order[groupStart[g]]].u);
+            TreePaths paths;
+            std::vector<Sum> dist;
+            for (size_t i = groupStart[g]; i < groupStart[g + 1]; ++i) {
+                const DistanceQuery& query = queries[order[i]];
+                Sum d;
+                if (query.type != QueryType::GraphDistance) {
+                    if (paths.weight.empty()) paths = treePathsFrom(source);
+                    if (paths.weight[query.v] == std::numeric_limits<Sum>::max()) {
+                        d = -1;
+                    } else {
+                        d = query.type == QueryType::Bottleneck ? paths.heaviest[query.v] : paths.weight[query.v];
+                    }
+                } else {
+                    if (dist.empty()) dist = shortestDistancesFrom(source);
+                    d = dist[query.v] == std::numeric_limits<Sum>::max() ? -1 : dist[query.v];
+                }
+                results[order[i]] = d;
+            }
+        }
+    };
+
+    // The other threads come from the budget shared by all the requests, see helper_threads.hpp
+    HelperThreads helpers(threads > 1 ? threads - 1 : 0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < helpers.count(); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    return results;
+}
+
+// Helper function: Dijkstra from u over the adjacency matrix, O(n^2) without a heap since every row is scanned anyway
+template <typename W, typename I>
+std::vector<typename BasicMST<W, I>::Sum> BasicMST<W, I>::shortestDistancesFrom(I u) const {
+    const Sum INF = std::numeric_limits<Sum>::max();
+    const I NONE = std::numeric_limits<I>::max();
+    std::vector<Sum> dist(numVertices, INF);
+    std::vector<char> done(numVertices, 0);
     dist[u] = 0;
-    q.push(u);
 
-    while (!q.empty()) {
-        int current = q.front();
-        q.pop();
+    for (I step = 0; step < numVertices; ++step) {
+        I current = NONE;
+        Sum best = INF;
+        for (I v = 0; v < numVertices; ++v) {
+            if (!done[v] && dist[v] < best) {
+                best = dist[v];
+                current = v;
+            }
+        }
+        if (current == NONE) break; // the other vertices are unreachable
+        done[current] = 1;
+
+        const std::vector<W>& row = graph[current];
+        for (I v = 0; v < numVertices; ++v) {
+            if (row[v] > 0 && !done[v] && best + row[v] < dist[v]) {
+                dist[v] = best + row[v];
+            }
+        }
+    }
+    return dist;
+}
+
+// Helper: runs fn(i) for every i < count, the indices are handed out to the threads one at a time
+template <typename Fn>
+static void parallelFor(size_t count, unsigned threads, const Fn& fn) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < count) fn(i);
+    };
+    // The other threads come from the budget shared by all the requests, see helper_threads.hpp
+    HelperThreads helpers(threads > 1 ? threads - 1 : 0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < helpers.count(); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+// Helper: z such that a standard normal value is in [-z, z] with the given probability (bisection on erf)
+static double normalQuantile(double confidence) {
+    double low = 0, high = 40;
+    for (int i = 0; i < 100; ++i) {
+        double mid = (low + high) / 2;
+        (std::erf(mid / std::sqrt(2.0)) < confidence ? low : high) = mid;
+    }
+    return high;
+}
+
+// Helper: t such that a Student t value with the given degrees of freedom is in [-t, t] with the given probability
+// (Cornish-Fisher expansion around the normal quantile, close enough from a few degrees of freedom on)
+static double studentQuantile(double confidence, double degrees) {
+    double z = normalQuantile(confidence);
+    double z2 = z * z;
+    double g1 = z * (z2 + 1) / 4;
+    double g2 = z * ((5 * z2 + 16) * z2 + 3) / 96;
+    double g3 = z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / 384;
+    double g4 = z * ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) / 92160;
+    return z + (g1 + (g2 + (g3 + g4 / degrees) / degrees) / degrees) / degrees;
+}
+
+// Helper: sources of the next round, the rounds grow by half of the sources computed so far
+static size_t nextRoundSize(size_t computed, size_t remaining) {
+    return std::min(remaining, std::max<size_t>(ESTIMATE_MIN_SOURCES, computed / 2));
+}
+
+// Function to estimate the average distance of the connected pairs
+// Every source s gives the sum S(s) of its distances and the count C(s) of the vertices it reaches, the average
+// is sum S / sum C over all the vertices and is estimated by the same ratio over the sources sampled without
+// replacement (its standard error comes from the residuals S - R * C, with the finite population correction,
+// and the interval uses the Student t quantile since the first rounds sample few sources)
+template <typename W, typename I>
+Estimate BasicMST<W, I>::estimateAverageEdgeCount(double relativeError, double confidence, uint64_t seed,
+                                                   unsigned threads) {
+    TRACE_SCOPE("estimateAverageEdgeCount");
+    const Sum INF = std::numeric_limits<Sum>::max();
+
+    // No edge: no connected pair, the average is 0 as in getAverageEdgeCount
+    if (mstEdges.empty()) return {0, 0, 0, 0, true};
+
+    std::vector<I> order(numVertices);
+    std::iota(order.begin(), order.end(), I(0));
+    std::mt19937_64 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<double> sums, counts;
+    double totalSum = 0, totalCount = 0;
+    while (true) {
+        size_t first = sums.size();
+        size_t round = nextRoundSize(first, numVertices - first);
+        sums.resize(first + round);
+        counts.resize(first + round);
+        parallelFor(round, threads, [&](size_t i) {
+            std::vector<Sum> dist = shortestDistancesFrom(order[first + i]);
+            double sum = 0, count = 0;
+            for (I v = 0; v < numVertices; ++v) {
+                if (dist[v] != INF && dist[v] > 0) {
+                    sum += static_cast<double>(dist[v]);
+                    ++count;
+                }
+            }
+            sums[first + i] = sum;
+            counts[first + i] = count;
+        });
+        for (size_t i = first; i < sums.size(); ++i) {
+            totalSum += sums[i];
+            totalCount += counts[i];
+        }
+
+        size_t k = sums.size();
+        double ratio = totalCount > 0 ? totalSum / totalCount : 0;
+        if (k == numVertices) return {ratio, ratio, ratio, k, true};
+        if (totalCount == 0 || k < 2) continue;
+
+        double residuals = 0;
+        for (size_t i = 0; i < k; ++i) {
+            double r = sums[i] - ratio * counts[i];
+            residuals += r * r;
+        }
+        double meanCount = totalCount / k;
+        double standardError = std::sqrt(residuals / (k - 1) / k * (1.0 - static_cast<double>(k) / numVertices)) / meanCount;
+        double halfWidth = studentQuantile(confidence, static_cast<double>(k - 1)) * standardError;
+        if (halfWidth <= relativeError * ratio) {
+            return {ratio, std::max(0.0, ratio - halfWidth), ratio + halfWidth, k, false};
+        }
+    }
+}
+
+// Function to bound the diameter between the eccentricities of the sources and the upper bounds they give
+template <typename W, typename I>
+Estimate BasicMST<W, I>::estimateDiameter(double relativeError, uint64_t seed, unsigned threads) {
+    TRACE_SCOPE("estimateDiameter");
+    const Sum INF = std::numeric_limits<Sum>::max();
+
+    // A shortest path is never longer than the tree of its component, so the MST weights bound every component
+    std::vector<Sum> weights = getTotalWeightPerComponent();
+    std::vector<double> componentUpper(weights.begin(), weights.end());
+
+    std::vector<I> order(numVertices);
+    std::iota(order.begin(), order.end(), I(0));
+    std::mt19937_64 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<char> used(numVertices, 0);
+    size_t nextRandom = 0, computed = 0;
+
+    double lower = 0;
+    I farthest = std::numeric_limits<I>::max(); // farthest vertex from the source of the lower bound
+    std::vector<I> round;
+    std::vector<Sum> eccentricity;
+    std::vector<I> far;
+    while (true) {
+        double upper = 0;
+        for (double bound : componentUpper) upper = std::max(upper, bound);
+        if (upper <= lower * (1 + relativeError) || computed == numVertices) {
+            bool exact = upper <= lower || computed == numVertices;
+            return {lower, lower, exact ? lower : upper, computed, exact};
+        }
+
+        // The farthest vertex found so far first (a double sweep), then random sources
+        round.clear();
+        size_t size = nextRoundSize(computed, numVertices - computed);
+        if (farthest != std::numeric_limits<I>::max() && !used[farthest]) {
+            used[farthest] = 1;
+            round.push_back(farthest);
+        }
+        while (round.size() < size && nextRandom < order.size()) {
+            I v = order[nextRandom++];
+            if (!used[v]) {
+                used[v] = 1;
+                round.push_back(v);
+            }
+        }
+
+        eccentricity.assign(round.size(), 0);
+        far.assign(round.size(), 0);
+        parallelFor(round.size(), threads, [&](size_t i) {
+            std::vector<Sum> dist = shortestDistancesFrom(round[i]);
+            far[i] = round[i];
+            for (I v = 0; v < numVertices; ++v) {
+                if (dist[v] != INF && dist[v] > eccentricity[i]) {
+                    eccentricity[i] = dist[v];
+                    far[i] = v;
+                }
+            }
+        });
+        computed += round.size();
+
+        for (size_t i = 0; i < round.size(); ++i) {
+            double ecc = static_cast<double>(eccentricity[i]);
+            if (ecc > lower || farthest == std::numeric_limits<I>::max()) {
+                lower = std::max(lower, ecc);
+                farthest = far[i];
+            }
+            double& bound = componentUpper[componentOf[round[i]]];
+            bound = std::min(bound, 2 * ecc);
+        }
+    }
+}
+
+// The supported instantiations
+template class BasicMST<uint8_t, uint32_t>;
+template class BasicMST<uint16_t, uint32_t>;
+template class BasicMST<int32_t, uint32_t>;
+template class BasicMST<int64_t, uint32_t>;
+template class BasicMST<float, uint32_t>;
+template class BasicMST<uint8_t, uint64_t>;
+template class BasicMST<uint16_t, uint64_t>;
+template class BasicMST<int32_t, uint64_t>;
+template class BasicMST<int64_t, uint64_t>;
+template class BasicMST<float, uint64_t>;
+
+// Interface of the instantiations an MST can hold
+struct MST::Concept {
+    virtual ~Concept() = default;
+    virtual std::vector<std::tuple<int, int, int64_t>> getEdges() = 0;
+    virtual MSTAnalytics getAnalytics() const = 0;
+    virtual std::string getAlgorithm() const = 0;
+    virtual std::string getSelectionReason() const = 0;
+    virtual int64_t getTotalWeight() = 0;
+    virtual int64_t getLongestDistance(int u, int v) = 0;
+    virtual double getAverageEdgeCount() = 0;
+    virtual int64_t getShortestDistance(int u, int v) = 0;
+    virtual int64_t getBottleneckDistance(int u, int v) = 0;
+    virtual int64_t getGraphDistance(int u, int v) = 0;
+    virtual int getComponentCount() = 0;
+    virtual int getComponent(int v) = 0;
+    virtual std::vector<std::vector<std::tuple<int, int, int64_t>>> getComponentTrees() = 0;
+    virtual std::vector<int64_t> getTotalWeightPerComponent() = 0;
+    virtual std::vector<double> getAverageEdgeCountPerComponent() = 0;
+    virtual std::vector<int64_t> batchQuery(const std::vector<DistanceQuery>& queries, unsigned threads) = 0;
+    virtual Estimate estimateAverageEdgeCount(double relativeError, double confidence, uint64_t seed) = 0;
+    virtual Estimate estimateDiameter(double relativeError, uint64_t seed) = 0;
+    virtual std::string getTypeName() const = 0;
+};
+
+// Helper: name of the types an MST can be instantiated with
+static const char* typeName(uint8_t) { return "uint8_t"; }
+static const char* typeName(uint16_t) { return "uint16_t"; }
+static const char* typeName(int32_t) { return "int32_t"; }
+static const char* typeName(uint32_t) { return "uint32_t"; }
+static const char* typeName(uint64_t) { return "uint64_t"; }
+
+// BasicMST<W, I> of a copy of the graph narrowed to W, vertices are passed as I (a negative one becomes out of range)
+template <typename W, typename I>
+struct MST::Model : MST::Concept {
+    BasicMST<W, I> mst;
+
+    Model(const Graph& graph, const std::string& algo, const std::vector<uint32_t>& internalOf = {})
+        : mst(narrow(graph), graph.getVertexCount(), algo, std::vector<I>(internalOf.begin(), internalOf.end())) {}
+    Model(const Graph& graph, const std::vector<std::tuple<int, int, int64_t>>& edges, MSTAnalytics analytics)
+        : mst(narrow(graph), graph.getVertexCount(), narrowEdges(edges), std::move(analytics)) {}
 
-        for (int neighbor = 0; neighbor < numVertices; ++neighbor) {
-            if (graph[current][neighbor] > 0 && dist[neighbor] == std::numeric_limits<int>::max()) {
-                dist[neighbor] = dist[current] + graph[current][neighbor];
-                q.push(neighbor);
+    static std::vector<std::vector<W>> narrow(const Graph& graph) {
+        TRACE_SCOPE("MST::narrow");
+        std::vector<std::vector<W>> matrix(graph.getVertexCount());
+        for (uint32_t u = 0; u < graph.getVertexCount(); ++u) {
+            matrix[u].assign(graph.getGraph()[u].begin(), graph.getGraph()[u].end());
+        }
+        return matrix;
+    }
+
+    // Edge ids are only used to break ties while the tree is computed, a restored edge gets its position
+    static std::vector<typename BasicMST<W, I>::Edge> narrowEdges(const std::vector<std::tuple<int, int, int64_t>>& edges) {
+        std::vector<typename BasicMST<W, I>::Edge> narrowed;
+        narrowed.reserve(edges.size());
+        for (const auto& edge : edges) {
+            narrowed.emplace_back(static_cast<I>(std::get<0>(edge)), static_cast<I>(std::get<1>(edge)),
+                                  static_cast<W>(std::get<2>(edge)), static_cast<I>(narrowed.size()));
+        }
+        return narrowed;
+    }
+
+    std::vector<std::tuple<int, int, int64_t>> getEdges() override {
+        std::vector<std::tuple<int, int, int64_t>> edges;
+        edges.reserve(mst.getEdges().size());
+        for (const auto& edge : mst.getEdges()) {
+            edges.emplace_back(static_cast<int>(std::get<0>(edge)), static_cast<int>(std::get<1>(edge)), std::get<2>(edge));
+        }
+        return edges;
+    }
+    MSTAnalytics getAnalytics() const override { return mst.getAnalytics(); }
+    std::string getAlgorithm() const override { return mst.getAlgorithm(); }
+    std::string getSelectionReason() const override { return mst.getSelectionReason(); }
+    int64_t getTotalWeight() override { return mst.getTotalWeight(); }
+    int64_t getLongestDistance(int u, int v) override { return mst.getLongestDistance(u, v); }
+    double getAverageEdgeCount() override { return mst.getAverageEdgeCount(); }
+    int64_t getShortestDistance(int u, int v) override { return mst.getShortestDistance(u, v); }
+    int64_t getBottleneckDistance(int u, int v) override { return mst.getBottleneckDistance(u, v); }
+    int64_t getGraphDistance(int u, int v) override { return mst.getGraphDistance(u, v); }
+    int getComponentCount() override { return static_cast<int>(mst.getComponentCount()); }
+    int getComponent(int v) override {
+        I component = mst.getComponent(v);
+        return component == std::numeric_limits<I>::max() ? -1 : static_cast<int>(component);
+    }
+    std::vector<std::vector<std::tuple<int, int, int64_t>>> getComponentTrees() override {
+        std::vector<std::vector<std::tuple<int, int, int64_t>>> trees;
+        for (const auto& tree : mst.getComponentTrees()) {
+            trees.emplace_back();
+            for (const auto& edge : tree) {
+                trees.back().emplace_back(static_cast<int>(std::get<0>(edge)), static_cast<int>(std::get<1>(edge)),
+                                          std::get<2>(edge));
             }
         }
+        return trees;
+    }
+    std::vector<int64_t> getTotalWeightPerComponent() override { return mst.getTotalWeightPerComponent(); }
+    std::vector<double> getAverageEdgeCountPerComponent() override { return mst.getAverageEdgeCountPerComponent(); }
+    std::vector<int64_t> batchQuery(const std::vector<DistanceQuery>& queries, unsigned threads) override {
+        return mst.batchQuery(queries, threads);
+    }
+    Estimate estimateAverageEdgeCount(double relativeError, double confidence, uint64_t seed) override {
+        return mst.estimateAverageEdgeCount(relativeError, confidence, seed);
+    }
+    Estimate estimateDiameter(double relativeError, uint64_t seed) override {
+        return mst.estimateDiameter(relativeError, seed);
+    }
+    std::string getTypeName() const override { return std::string(typeName(W())) + "/" + typeName(I()); }
+};
+
+// Helper: calls make(W(), I()) with the narrowest weight and index types that hold the graph
+template <typename Make>
+static void dispatchNarrowest(const Graph& graph, const Make& make) {
+    int32_t maxWeight = 0;
+    for (const auto& row : graph.getGraph()) {
+        for (int32_t weight : row) maxWeight = std::max(maxWeight, weight);
     }
+    // Edge ids are indices too, a dense graph can have more edges than vertices fit in uint32_t
+    bool wideIndex = graph.getEdgeCount() >= std::numeric_limits<uint32_t>::max();
 
-    return dist[v] == std::numeric_limits<int>::max() ? -1 : dist[v];
+    if (maxWeight <= std::numeric_limits<uint8_t>::max()) {
+        wideIndex ? make(uint8_t(), uint64_t()) : make(uint8_t(), uint32_t());
+    } else if (maxWeight <= std::numeric_limits<uint16_t>::max()) {
+        wideIndex ? make(uint16_t(), uint64_t()) : make(uint16_t(), uint32_t());
+    } else {
+        wideIndex ? make(int32_t(), uint64_t()) : make(int32_t(), uint32_t());
+    }
+}
+
+// Vertices of an MST computed on a reordered graph: the ids of the client are renamed on the way in and back
+// on the way out. The components are numbered in the order of their smallest client vertex, as without reordering.
+struct MST::Relabelling {
+    VertexOrder order;
+    VertexPermutation vertices;
+    std::vector<int> componentToClient; // component of the reordered graph -> component number of the client
+
+    // Vertex of the reordered graph, out of range vertices stay out of range
+    int toInternal(int v) const {
+        return v >= 0 && static_cast<size_t>(v) < vertices.toInternal.size() ? static_cast<int>(vertices.toInternal[v]) : v;
+    }
+    int toClient(int v) const { return static_cast<int>(vertices.toClient[v]); }
+
+    // Values per component moved to the numbering of the client, empty (not computed) values stay empty
+    template <typename T>
+    std::vector<T> componentsToClient(const std::vector<T>& values) const {
+        if (values.size() != componentToClient.size()) return values;
+        std::vector<T> moved(values.size());
+        for (size_t c = 0; c < values.size(); ++c) {
+            moved[componentToClient[c]] = values[c];
+        }
+        return moved;
+    }
+};
+
+MST::MST(const Graph& graph, const std::string& algo, VertexOrder order) {
+    // Rejected before the graph is copied
+    checkMSTAlgorithm(algo);
+    if (order == VertexOrder::None) {
+        dispatchNarrowest(graph, [&](auto weight, auto index) {
+            impl = std::make_shared<Model<decltype(weight), decltype(index)>>(graph, algo);
+        });
+    } else {
+        auto relabel = std::make_shared<Relabelling>();
+        relabel->order = order;
+        relabel->vertices = computeVertexOrder(graph, order);
+        {
+            Graph reordered = permuteGraph(graph, relabel->vertices);
+            dispatchNarrowest(reordered, [&](auto weight, auto index) {
+                impl = std::make_shared<Model<decltype(weight), decltype(index)>>(reordered, algo,
+                                                                                   relabel->vertices.toInternal);
+            });
+        }
+        relabel->componentToClient.assign(impl->getComponentCount(), -1);
+        int next = 0;
+        for (uint32_t v = 0; v < graph.getVertexCount(); ++v) {
+            int& component = relabel->componentToClient[impl->getComponent(relabel->toInternal(v))];
+            if (component < 0) component = next++;
+        }
+        relabelling = std::move(relabel);
+    }
+    algorithm = impl->getAlgorithm();
+    selectionReason = impl->getSelectionReason();
+}
+
+MST::MST(const Graph& graph, const std::string& algo, const std::vector<std::tuple<int, int, int64_t>>& edges,
+         MSTAnalytics analytics)
+    : algorithm(algo) {
+    dispatchNarrowest(graph, [&](auto weight, auto index) {
+        impl = std::make_shared<Model<decltype(weight), decltype(index)>>(graph, edges, analytics);
+    });
+}
+
+MST::MST() : MST(Graph(), "prim") {}
+
+std::vector<std::tuple<int, int, int64_t>> MST::getEdges() {
+    std::vector<std::tuple<int, int, int64_t>> edges = impl->getEdges();
+    if (relabelling) {
+        for (auto& edge : edges) {
+            std::get<0>(edge) = relabelling->toClient(std::get<0>(edge));
+            std::get<1>(edge) = relabelling->toClient(std::get<1>(edge));
+        }
+    }
+    return edges;
+}
+MSTAnalytics MST::getAnalytics() const {
+    MSTAnalytics analytics = impl->getAnalytics();
+    if (relabelling) {
+        analytics.averageEdgeCountPerComponent = relabelling->componentsToClient(analytics.averageEdgeCountPerComponent);
+    }
+    return analytics;
+}
+const std::string& MST::getAlgorithm() const { return algorithm; }
+const std::string& MST::getSelectionReason() const { return selectionReason; }
+VertexOrder MST::getVertexOrder() const { return relabelling ? relabelling->order : VertexOrder::None; }
+
+std::string describeMSTCreation(const MST& mst) {
+    std::string line = "MST created using " + mst.getAlgorithm() + " algorithm";
+    if (!mst.getSelectionReason().empty()) line += " (" + mst.getSelectionReason() + ")";
+    if (mst.getVertexOrder() != VertexOrder::None) line += ", vertices in " + vertexOrderName(mst.getVertexOrder()) + " order";
+    return line + "\n";
+}
+int64_t MST::getTotalWeight() { return impl->getTotalWeight(); }
+int64_t MST::getLongestDistance(int u, int v) {
+    if (relabelling) return impl->getLongestDistance(relabelling->toInternal(u), relabelling->toInternal(v));
+    return impl->getLongestDistance(u, v);
+}
+double MST::getAverageEdgeCount() { return impl->getAverageEdgeCount(); }
+int64_t MST::getShortestDistance(int u, int v) {
+    if (relabelling) return impl->getShortestDistance(relabelling->toInternal(u), relabelling->toInternal(v));
+    return impl->getShortestDistance(u, v);
+}
+
+int64_t MST::getBottleneckDistance(int u, int v) {
+    if (relabelling) return impl->getBottleneckDistance(relabelling->toInternal(u), relabelling->toInternal(v));
+    return impl->getBottleneckDistance(u, v);
+}
+
+int64_t MST::getGraphDistance(int u, int v) {
+    if (relabelling) return impl->getGraphDistance(relabelling->toInternal(u), relabelling->toInternal(v));
+    return impl->getGraphDistance(u, v);
+}
+int MST::getComponentCount() { return impl->getComponentCount(); }
+int MST::getComponent(int v) {
+    if (!relabelling) return impl->getComponent(v);
+    int component = impl->getComponent(relabelling->toInternal(v));
+    return component < 0 ? -1 : relabelling->componentToClient[component];
+}
+std::vector<std::vector<std::tuple<int, int, int64_t>>> MST::getComponentTrees() {
+    std::vector<std::vector<std::tuple<int, int, int64_t>>> trees = impl->getComponentTrees();
+    if (!relabelling) return trees;
+    for (auto& tree : trees) {
+        for (auto& edge : tree) {
+            std::get<0>(edge) = relabelling->toClient(std::get<0>(edge));
+            std::get<1>(edge) = relabelling->toClient(std::get<1>(edge));
+        }
+    }
+    return relabelling->componentsToClient(trees);
+}
+std::vector<int64_t> MST::getTotalWeightPerComponent() {
+    std::vector<int64_t> weights = impl->getTotalWeightPerComponent();
+    return relabelling ? relabelling->componentsToClient(weights) : weights;
+}
+std::vector<double> MST::getAverageEdgeCountPerComponent() {
+    std::vector<double> averages = impl->getAverageEdgeCountPerComponent();
+    return relabelling ? relabelling->componentsToClient(averages) : averages;
+}
+std::vector<int64_t> MST::batchQuery(const std::vector<DistanceQuery>& queries, unsigned threads) {
+    if (!relabelling) return impl->batchQuery(queries, threads);
+    std::vector<DistanceQuery> renamed(queries);
+    for (DistanceQuery& query : renamed) {
+        query.u = relabelling->toInternal(query.u);
+        query.v = relabelling->toInternal(query.v);
+    }
+    return impl->batchQuery(renamed, threads);
+}
+Estimate MST::estimateAverageEdgeCount(double relativeError, double confidence, uint64_t seed) {
+    return impl->estimateAverageEdgeCount(relativeError, confidence, seed);
 }
+Estimate MST::estimateDiameter(double relativeError, uint64_t seed) { return impl->estimateDiameter(relativeError, seed); }
+std::string MST::getTypeName() const { return impl->getTypeName(); }
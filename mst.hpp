@@ -1,40 +1,229 @@
 #ifndef MST_HPP
 #define MST_HPP
 
+#include "graph.hpp"
+#include "vertex_order.hpp"
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <tuple>
 #include <string>
+#include <type_traits>
+#include <utility>
 
-class MST {
+// Kind of a distance query, see MST::getLongestDistance, MST::getShortestDistance,
+// MST::getBottleneckDistance and MST::getGraphDistance
+enum class QueryType { Longest, Shortest, Bottleneck, GraphDistance };
+
+// One (u, v) query of a batch
+struct DistanceQuery {
+    QueryType type;
+    int u;
+    int v;
+};
+
+// Results of the all-pairs analysis, the expensive part of the analysis of an MST.
+// They are computed on first use, kept by the MST and stored in the snapshots of the server.
+struct MSTAnalytics {
+    double averageEdgeCount = -1;                    // -1 = not computed yet
+    std::vector<double> averageEdgeCountPerComponent; // empty = not computed yet
+};
+
+// Algorithm picked for a graph by the "auto" mode of the MST, and why
+struct MSTChoice {
+    std::string algorithm; // "prim" or "boruvka"
+    std::string reason;
+};
+
+#define AUTO_DENSE_DENSITY 0.9        // "auto": at least this density is a near-complete graph
+#define AUTO_PRIM_MIN_WEIGHT 65536     // "auto": a near-complete graph with heavier edges goes to Prim
+
+// Picks the algorithm expected to be faster for a graph from its size, density and heaviest edge
+// (the thresholds were measured with mst_benchmark)
+MSTChoice chooseMSTAlgorithm(uint64_t vertices, uint64_t edges, int64_t maxWeight);
+
+// Throws std::invalid_argument unless algo is "prim", "boruvka", "auto" or "race"
+void checkMSTAlgorithm(const std::string& algo);
+
+// Estimate of an analysis value computed from a sample of sources
+struct Estimate {
+    double value;
+    double low, high;        // interval holding the exact value (with the requested confidence)
+    uint64_t sources;        // shortest path trees computed
+    bool exact;              // every vertex was a source or the bounds met, low == value == high
+};
+
+#define ESTIMATE_MIN_SOURCES 32 // Sources of the first round of an estimate
+
+// Type used to add up weights of type W: 64 bits for the integral weights, so sums can not overflow
+template <typename W>
+using WeightSum = typename std::conditional<std::is_floating_point<W>::value, double, int64_t>::type;
+
+// MST over the weight type W and the vertex index type I, instantiated for the types of BasicGraph
+template <typename W, typename I = uint32_t>
+class BasicMST {
 public:
-    // this constructor is used to create the MST using the given algorithm
-    MST(const std::vector<std::vector<int>>& graph, int n, const std::string& algo);
+    using Sum = WeightSum<W>;
+    using Edge = std::tuple<I, I, W, I>; // touple<from, to, weight, id>
+
+    // this constructor is used to create the MST using the given algorithm:
+    // "prim", "boruvka", "auto" (chosen by chooseMSTAlgorithm) or "race" (both run at the same time,
+    // the first to finish is kept and the other one is cancelled). Throws std::invalid_argument otherwise.
+    // internalOf: for a graph whose vertices were relabelled (see VertexOrder), the vertex of the graph of every
+    // vertex of the client. The edges are then listed in the order of the client, so ties between equal weights
+    // are broken as without the relabelling and the tree is the same.
+    BasicMST(std::vector<std::vector<W>> graph, I n, const std::string& algo, std::vector<I> internalOf = {});
     // Constructor without algorithm
-    MST(const std::vector<std::vector<int>>& graph, int n): graph(graph), numVertices(n) {}
+    BasicMST(std::vector<std::vector<W>> graph, I n): numVertices(n), graph(std::move(graph)) {}
+    // Restores an MST computed earlier from its edges and analytics, nothing is recomputed
+    BasicMST(std::vector<std::vector<W>> graph, I n, std::vector<Edge> edges, MSTAnalytics analytics)
+        : numVertices(n), graph(std::move(graph)), mstEdges(std::move(edges)), analytics(std::move(analytics)) {}
     // Empty constructor
-    MST() : graph(), numVertices(0) {}
+    BasicMST() : numVertices(0), graph() {}
 
 
     // MST calculation functions
-    std::vector<std::tuple<int, int, int, int>> boruvkaMST();
-    std::vector<std::tuple<int, int, int, int>> primMST();
+    std::vector<Edge> boruvkaMST();
+    std::vector<Edge> primMST();
+
+    // MST edges computed by the constructor
+    const std::vector<Edge>& getEdges() const { return mstEdges; }
+    // The analytics computed so far
+    const MSTAnalytics& getAnalytics() const { return analytics; }
+    // Algorithm that computed the tree, and why it was picked ("" if it was requested by name)
+    const std::string& getAlgorithm() const { return algorithm; }
+    const std::string& getSelectionReason() const { return selectionReason; }
 
     // Analysis functions
-    int getTotalWeight();
-    int getLongestDistance(int u, int v);        // Longest distance between two vertices u and v
+    Sum getTotalWeight();
+    // Distances between u and v, -1 if they are in different components or out of range.
+    // Longest and shortest distance are measured on the MST, where the path between two vertices is unique,
+    // so both are the weight of the tree path between u and v.
+    Sum getLongestDistance(I u, I v);
     double getAverageEdgeCount();    // Average between all pairs of vertices
-    int getShortestDistance(int u, int v);       // Shortest distance between two vertices u and v
+    Sum getShortestDistance(I u, I v);
+    Sum getBottleneckDistance(I u, I v);     // heaviest edge on the tree path between u and v
+    Sum getGraphDistance(I u, I v);          // shortest path in the graph (Dijkstra)
+
+    // Spanning forest: a disconnected graph gets one tree per connected component.
+    // Components are numbered in the order of their smallest vertex.
+    I getComponentCount();
+    I getComponent(I v);                     // Component of vertex v, numeric_limits<I>::max() if out of range
+    std::vector<std::vector<Edge>> getComponentTrees(); // MST edges of every component
+    std::vector<Sum> getTotalWeightPerComponent();
+    std::vector<double> getAverageEdgeCountPerComponent(); // Average over the pairs inside every component
+
+    // Evaluates many distance queries at once (see QueryType), queries with the
+    // same source share one walk of the tree and one Dijkstra
+    // and the sources are spread over the given number of threads (0 = hardware concurrency).
+    // The results are in the order of the queries, -1 for unreachable or out of range vertices.
+    std::vector<Sum> batchQuery(const std::vector<DistanceQuery>& queries, unsigned threads = 0);
+
+    // Approximate analytics for graphs too large for the all-pairs analysis (O(n^3)). Both compute shortest
+    // path trees (Dijkstra on the graph, O(n^2) each) from sampled sources, a round at a time on the given
+    // number of threads (0 = hardware concurrency), until the interval is within relativeError of the estimate.
+    // The same seed gives the same sources.
+    // Average over the connected pairs, as getAverageEdgeCount: random sources, the interval is a normal
+    // confidence interval of the ratio estimator with the given confidence (e.g. 0.95).
+    Estimate estimateAverageEdgeCount(double relativeError, double confidence, uint64_t seed = 1, unsigned threads = 0);
+    // Longest shortest path between two connected vertices. The interval is certain: the farthest vertex
+    // from a source is a lower bound, twice its distance (or the MST weight of the component) an upper bound.
+    // Every round also starts from the farthest vertex found so far, so the bounds usually meet quickly.
+    Estimate estimateDiameter(double relativeError, uint64_t seed = 1, unsigned threads = 0);
 
 private:
-    int numVertices;
-    std::vector<std::vector<int>> graph;         // Graph representation
-    // touple<from, to, weight, id>
-    std::vector<std::tuple<int, int, int, int>> mstEdges; // Holds the MST edges
+    I numVertices;
+    std::vector<std::vector<W>> graph;         // Graph representation
+    std::vector<Edge> mstEdges; // Holds the MST edges
+    std::vector<I> internalOf;  // Relabelling of the vertices of the client, empty if there is none
+    std::vector<I> componentOf; // Component of every vertex, computed on first use
+    std::vector<I> treeStart;   // Tree adjacency (see computeComponents), computed with the components
+    std::vector<std::pair<I, W>> treeNeighbours;
+    I componentCount = 0;
+    MSTAnalytics analytics;     // Averages, computed on first use
+    std::string algorithm;
+    std::string selectionReason;
 
     // Helper functions
     void calculateMSTUsingPrim();
     void calculateMSTUsingBoruvka();
-    std::vector<std::tuple<int, int, int, int>> convertGraphToEdges();
+    void calculateMSTAutomatically();
+    void calculateMSTByRace();
+    std::vector<Edge> convertGraphToEdges();
+    // Path weight and heaviest edge from a source to every vertex, weight numeric_limits<Sum>::max() if unreachable
+    struct TreePaths {
+        std::vector<Sum> weight;
+        std::vector<Sum> heaviest;
+    };
+    TreePaths treePathsFrom(I u) const;
+    void computeComponents();
+    std::vector<std::vector<Sum>> allPairsShortestPaths() const; // Floyd-Warshall, numeric_limits<Sum>::max() if unreachable
+    std::vector<Sum> shortestDistancesFrom(I u) const;          // Dijkstra, numeric_limits<Sum>::max() if unreachable
 };
 
+// MST of an uploaded Graph, used by the servers.
+// The graph is copied into the narrowest BasicMST that holds it: the weights into uint8_t, uint16_t or
+// int32_t (the smallest type that fits the heaviest edge) and the vertex and edge indices into uint32_t,
+// or uint64_t if there are more edges than that. Narrow weights make the matrix and edge scans cheaper.
+// With a VertexOrder other than None, the MST is computed (and analysed) on the graph with its vertices
+// relabelled in that order, the vertices and components of the queries and results stay the ones of the client.
+// Copies of an MST share the computed tree.
+class MST {
+public:
+    // Computes the MST of the graph using the given algorithm ("prim", "boruvka", "auto" or "race", see BasicMST),
+    // on the graph reordered in the given order
+    MST(const Graph& graph, const std::string& algo, VertexOrder order = VertexOrder::None);
+    // Restores the MST of the graph computed earlier by the given algorithm (see getEdges and getAnalytics)
+    MST(const Graph& graph, const std::string& algo, const std::vector<std::tuple<int, int, int64_t>>& edges,
+        MSTAnalytics analytics);
+    // Empty MST
+    MST();
+
+    // MST edges as <from, to, weight>
+    std::vector<std::tuple<int, int, int64_t>> getEdges();
+    MSTAnalytics getAnalytics() const;
+    // Algorithm the MST was computed with ("prim" or "boruvka", also when it was picked by "auto" or "race")
+    const std::string& getAlgorithm() const;
+    // Why "auto" or "race" picked the algorithm, "" if it was requested by name
+    const std::string& getSelectionReason() const;
+    // Order the vertices were relabelled in before the MST was computed
+    VertexOrder getVertexOrder() const;
+
+    // Analysis functions, see BasicMST
+    int64_t getTotalWeight();
+    int64_t getLongestDistance(int u, int v);
+    double getAverageEdgeCount();
+    int64_t getShortestDistance(int u, int v);
+    int64_t getBottleneckDistance(int u, int v);
+    int64_t getGraphDistance(int u, int v);
+
+    int getComponentCount();
+    int getComponent(int v); // -1 if out of range
+    std::vector<std::vector<std::tuple<int, int, int64_t>>> getComponentTrees(); // edges as getEdges, per component
+    std::vector<int64_t> getTotalWeightPerComponent();
+    std::vector<double> getAverageEdgeCountPerComponent();
+
+    std::vector<int64_t> batchQuery(const std::vector<DistanceQuery>& queries, unsigned threads = 0);
+    Estimate estimateAverageEdgeCount(double relativeError, double confidence, uint64_t seed = 1);
+    Estimate estimateDiameter(double relativeError, uint64_t seed = 1);
+
+    // Weight and index types of the instantiation in use, e.g. "uint8_t/uint32_t"
+    std::string getTypeName() const;
+
+private:
+    struct Concept;
+    template <typename W, typename I>
+    struct Model;
+
+    struct Relabelling;
+
+    std::shared_ptr<Concept> impl;
+    std::shared_ptr<const Relabelling> relabelling; // null if the vertices are the ones of the client
+    std::string algorithm;
+    std::string selectionReason;
+};
+
+// Line sent to the client once its MST was computed, with the reason of an automatic choice
+std::string describeMSTCreation(const MST& mst);
+
 #endif // MST_HPP
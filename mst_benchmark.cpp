@@ -0,0 +1,187 @@
+// Benchmark of the MST algorithms on generated graphs.
+// Times prim() and boruvka() on the same edge lists for every graph family, size and weight range,
+// and compares the choice of the "auto" algorithm with the fastest one.
+// The thresholds of chooseMSTAlgorithm (mst.hpp) come from its output.
+// A second table shuffles the vertex ids (as arbitrary uploaded ids would be) and compares the algorithms on
+// the shuffled graph with the same graph relabelled in every VertexOrder, with the cost of the relabelling.
+//
+// Usage: ./mst_benchmark [max-vertices] [repeats]
+
+#include "boruvka.hpp"
+#include "graph_generator.hpp"
+#include "mst.hpp"
+#include "prim.hpp"
+#include "vertex_order.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// One graph of the benchmark
+struct BenchmarkCase {
+    GeneratorSpec spec;
+    int64_t maxWeight; // weights are spread over [1, maxWeight]
+};
+
+// Helper: best time of `repeats` runs of run(), in milliseconds
+template <typename Run>
+static double bestTime(int repeats, const Run& run) {
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Helper: edges of the graph with the weights rescaled to [1, maxWeight], in the type MST would narrow them to
+template <typename W>
+static std::vector<std::tuple<uint32_t, uint32_t, W, uint32_t>> edgeList(const Graph& graph, int64_t maxWeight) {
+    std::vector<std::tuple<uint32_t, uint32_t, W, uint32_t>> edges;
+    edges.reserve(graph.getEdgeCount());
+    for (uint32_t u = 0; u < graph.getVertexCount(); ++u) {
+        for (uint32_t v = u + 1; v < graph.getVertexCount(); ++v) {
+            int64_t weight = graph.getGraph()[u][v];
+            if (weight == 0) continue;
+            // Spread the generated weights (1..GENERATOR_MAX_WEIGHT) over the whole range
+            uint64_t mixed = (static_cast<uint64_t>(weight) * 0x9E3779B97F4A7C15ULL) ^ (u * 31ULL + v);
+            W scaled = static_cast<W>(1 + mixed % static_cast<uint64_t>(maxWeight));
+            edges.emplace_back(u, v, scaled, static_cast<uint32_t>(edges.size()));
+        }
+    }
+    return edges;
+}
+
+// Times both algorithms on one graph, returns <prim ms, boruvka ms>
+template <typename W>
+static std::pair<double, double> timeAlgorithms(const Graph& graph, int64_t maxWeight, int repeats) {
+    auto edges = edgeList<W>(graph, maxWeight);
+    uint32_t n = graph.getVertexCount();
+    double primTime = bestTime(repeats, [&]() { prim(edges, n); });
+    double boruvkaTime = bestTime(repeats, [&]() { boruvka(edges, n); });
+    return {primTime, boruvkaTime};
+}
+
+// Helper: the graph with its vertex ids shuffled
+static Graph shuffleVertices(const Graph& graph, uint64_t seed) {
+    VertexPermutation shuffle;
+    shuffle.toClient.resize(graph.getVertexCount());
+    std::iota(shuffle.toClient.begin(), shuffle.toClient.end(), 0u);
+    std::mt19937_64 rng(seed);
+    std::shuffle(shuffle.toClient.begin(), shuffle.toClient.end(), rng);
+    shuffle.toInternal.resize(shuffle.toClient.size());
+    for (uint32_t i = 0; i < shuffle.toClient.size(); ++i) {
+        shuffle.toInternal[shuffle.toClient[i]] = i;
+    }
+    return permuteGraph(graph, shuffle);
+}
+
+// Times the relabelling of shuffled graphs in every order and both algorithms on the result
+static void benchmarkReordering(long maxVertices, int repeats) {
+    const int64_t maxWeight = 65535;
+    std::cout << "\nVertex reordering (shuffled ids, weights up to " << maxWeight << ", speedup against none)\n";
+    std::cout << std::left << std::setw(10) << "graph" << std::right << std::setw(8) << "V" << std::setw(10) << "E"
+              << std::setw(8) << "order" << std::setw(12) << "reorder ms" << std::setw(11) << "prim ms"
+              << std::setw(12) << "boruvka ms" << std::setw(8) << "prim x" << std::setw(11) << "boruvka x"
+              << std::setw(7) << "net x" << "\n";
+
+    for (long vertices = 250; vertices <= maxVertices; vertices *= 2) {
+        for (GeneratorSpec spec : {GeneratorSpec{GeneratorKind::Sparse, vertices, 4, 1},
+                                   GeneratorSpec{GeneratorKind::Sparse, vertices, 32, 1},
+                                   GeneratorSpec{GeneratorKind::Grid, vertices, 0, 1},
+                                   GeneratorSpec{GeneratorKind::Geometric, vertices, 0, 1},
+                                   GeneratorSpec{GeneratorKind::Dense, vertices, 0.1, 1}}) {
+            Graph shuffled = shuffleVertices(generateGraph(spec), 1);
+            std::pair<double, double> baseline;
+            for (VertexOrder order : {VertexOrder::None, VertexOrder::BFS, VertexOrder::RCM, VertexOrder::Degree}) {
+                Graph reordered;
+                double reorderTime = order == VertexOrder::None ? 0 : bestTime(repeats, [&]() {
+                    reordered = permuteGraph(shuffled, computeVertexOrder(shuffled, order));
+                });
+                std::pair<double, double> times =
+                    timeAlgorithms<uint16_t>(order == VertexOrder::None ? shuffled : reordered, maxWeight, repeats);
+                if (order == VertexOrder::None) baseline = times;
+                // net: the faster algorithm on the shuffled graph against relabelling + the faster one after it
+                double net = std::min(baseline.first, baseline.second) / (reorderTime + std::min(times.first, times.second));
+
+                std::cout << std::left << std::setw(10) << generatorKindName(spec.kind) << std::right << std::setw(8)
+                          << shuffled.getVertexCount() << std::setw(10) << shuffled.getEdgeCount() << std::setw(8)
+                          << vertexOrderName(order) << std::fixed << std::setprecision(2) << std::setw(12)
+                          << reorderTime << std::setw(11) << times.first << std::setw(12) << times.second
+                          << std::setw(8) << baseline.first / times.first << std::setw(11)
+                          << baseline.second / times.second << std::setw(7) << net << "\n";
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long maxVertices = argc > 1 ? std::stol(argv[1]) : 2000;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    std::vector<BenchmarkCase> cases;
+    for (long vertices = 250; vertices <= maxVertices; vertices *= 2) {
+        for (int64_t maxWeight : {int64_t(255), int64_t(65535), int64_t(1) << 30}) {
+            cases.push_back({{GeneratorKind::Sparse, vertices, 4, 1}, maxWeight});
+            cases.push_back({{GeneratorKind::Sparse, vertices, 32, 1}, maxWeight});
+            cases.push_back({{GeneratorKind::Grid, vertices, 0, 1}, maxWeight});
+            cases.push_back({{GeneratorKind::Geometric, vertices, 0, 1}, maxWeight});
+            cases.push_back({{GeneratorKind::Dense, vertices, 0.1, 1}, maxWeight});
+            cases.push_back({{GeneratorKind::Dense, vertices, 0.5, 1}, maxWeight});
+            cases.push_back({{GeneratorKind::Complete, vertices, 0, 1}, maxWeight});
+        }
+    }
+
+    std::cout << std::left << std::setw(10) << "graph" << std::right << std::setw(8) << "V" << std::setw(10) << "E"
+              << std::setw(9) << "density" << std::setw(12) << "max weight" << std::setw(11) << "prim ms"
+              << std::setw(12) << "boruvka ms" << std::setw(9) << "fastest" << std::setw(9) << "auto" << "\n";
+
+    double primTotal = 0, boruvkaTotal = 0, autoTotal = 0, bestTotal = 0;
+    int autoRight = 0;
+    for (const BenchmarkCase& c : cases) {
+        Graph graph = generateGraph(c.spec);
+        uint64_t n = graph.getVertexCount(), m = graph.getEdgeCount();
+        double density = n > 1 ? 2.0 * m / (static_cast<double>(n) * (n - 1)) : 0;
+
+        // Same narrowing as MST: the smallest weight type that holds the heaviest edge
+        std::pair<double, double> times;
+        if (c.maxWeight <= std::numeric_limits<uint8_t>::max()) {
+            times = timeAlgorithms<uint8_t>(graph, c.maxWeight, repeats);
+        } else if (c.maxWeight <= std::numeric_limits<uint16_t>::max()) {
+            times = timeAlgorithms<uint16_t>(graph, c.maxWeight, repeats);
+        } else {
+            times = timeAlgorithms<int32_t>(graph, c.maxWeight, repeats);
+        }
+
+        std::string fastest = times.first <= times.second ? "prim" : "boruvka";
+        MSTChoice choice = chooseMSTAlgorithm(n, m, c.maxWeight);
+        double autoTime = choice.algorithm == "prim" ? times.first : times.second;
+        primTotal += times.first;
+        boruvkaTotal += times.second;
+        autoTotal += autoTime;
+        bestTotal += std::min(times.first, times.second);
+        autoRight += choice.algorithm == fastest;
+
+        std::cout << std::left << std::setw(10) << generatorKindName(c.spec.kind) << std::right << std::setw(8) << n
+                  << std::setw(10) << m << std::setw(9) << std::fixed << std::setprecision(3) << density
+                  << std::setw(12) << c.maxWeight << std::setw(11) << std::setprecision(2) << times.first
+                  << std::setw(12) << times.second << std::setw(9) << fastest << std::setw(9) << choice.algorithm
+                  << "\n";
+    }
+
+    std::cout << "\nTotal ms: prim " << primTotal << ", boruvka " << boruvkaTotal << ", auto " << autoTotal
+              << ", fastest " << bestTotal << "\n";
+    std::cout << "auto picked the fastest algorithm for " << autoRight << " of " << cases.size() << " graphs\n";
+
+    benchmarkReordering(maxVertices, repeats);
+    return 0;
+}
@@ -0,0 +1,458 @@
+// Tests of the MST algorithms and of the analysis of an MST.
+// Every check compares against a reference computed here independently of mst.cpp:
+//   - Prim and Borůvka (and "auto") give a spanning tree of the Kruskal weight on random graphs, also in the
+//     weight and index types the servers never dispatch to
+//   - "race" keeps the tree of the first algorithm to finish and says which one was cancelled, a cancelled
+//     Prim or Borůvka returns nothing, and without a helper thread "race" falls back to "auto"
+//   - a disconnected graph gives a spanning forest with the tree and the analytics of every component
+//   - the estimates of the average distance and of the diameter hold the exact values in their interval
+//   - the tree and the query answers do not depend on the order the vertices are relabelled in
+//
+// Usage: ./mst_test (exits with 1 if a check failed), "make test" builds and runs it
+
+#include "boruvka.hpp"
+#include "graph_generator.hpp"
+#include "helper_threads.hpp"
+#include "mst.hpp"
+#include "prim.hpp"
+#include "test_util.hpp"
+#include "vertex_order.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static const VertexOrder ORDERS[] = {VertexOrder::None, VertexOrder::BFS, VertexOrder::RCM, VertexOrder::Degree};
+static const char* const ALGORITHMS[] = {"prim", "boruvka", "auto"};
+
+// Helper: random graph with weights in [1, maxWeight], few distinct weights give many ties
+static Graph randomGraph(uint32_t n, double edgeProbability, int32_t maxWeight, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> coin(0, 1);
+    std::uniform_int_distribution<int32_t> weight(1, maxWeight);
+    Graph graph(n);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t v = u + 1; v < n; ++v) {
+            if (coin(rng) < edgeProbability) graph.addEdge(u, v, weight(rng));
+        }
+    }
+    return graph;
+}
+
+// Graphs shared by the tests: generated families, many ties, disconnected ones
+static std::vector<std::pair<std::string, Graph>> testGraphs() {
+    std::vector<std::pair<std::string, Graph>> graphs;
+    const GeneratorKind kinds[] = {GeneratorKind::Sparse, GeneratorKind::Dense, GeneratorKind::Grid,
+                                   GeneratorKind::Geometric, GeneratorKind::Complete};
+    for (GeneratorKind kind : kinds) {
+        for (uint64_t seed = 1; seed <= 2; ++seed) {
+            GeneratorSpec spec{kind, 120, 0, seed};
+            graphs.emplace_back(generatorKindName(kind) + " seed " + std::to_string(seed), generateGraph(spec, 1));
+        }
+    }
+    // Average degree 1.5: several components
+    graphs.emplace_back("sparse disconnected", generateGraph(GeneratorSpec{GeneratorKind::Sparse, 150, 1.5, 7}, 1));
+    graphs.emplace_back("ties", randomGraph(100, 0.1, 3, 11));
+    graphs.emplace_back("ties disconnected", randomGraph(100, 0.015, 2, 12));
+    graphs.emplace_back("heavy weights", randomGraph(80, 0.2, std::numeric_limits<int32_t>::max(), 13));
+    return graphs;
+}
+
+// Helper: weight of a minimum spanning forest by Kruskal, the reference of the algorithms
+static int64_t kruskalWeight(const Graph& graph) {
+    uint32_t n = graph.getVertexCount();
+    std::vector<std::tuple<int64_t, uint32_t, uint32_t>> edges;
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t v = u + 1; v < n; ++v) {
+            if (graph.getGraph()[u][v] != 0) edges.emplace_back(graph.getGraph()[u][v], u, v);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<uint32_t> parent(n);
+    std::iota(parent.begin(), parent.end(), 0u);
+    auto find = [&parent](uint32_t v) {
+        while (parent[v] != v) v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    int64_t weight = 0;
+    for (const auto& edge : edges) {
+        uint32_t a = find(std::get<1>(edge)), b = find(std::get<2>(edge));
+        if (a == b) continue;
+        parent[a] = b;
+        weight += std::get<0>(edge);
+    }
+    return weight;
+}
+
+// Helper: shortest distances between all the pairs (Floyd-Warshall), -1 if unreachable
+static std::vector<std::vector<int64_t>> allPairs(const Graph& graph) {
+    uint32_t n = graph.getVertexCount();
+    std::vector<std::vector<int64_t>> dist(n, std::vector<int64_t>(n, -1));
+    for (uint32_t u = 0; u < n; ++u) {
+        dist[u][u] = 0;
+        for (uint32_t v = 0; v < n; ++v) {
+            if (u != v && graph.getGraph()[u][v] != 0) dist[u][v] = graph.getGraph()[u][v];
+        }
+    }
+    for (uint32_t k = 0; k < n; ++k) {
+        for (uint32_t i = 0; i < n; ++i) {
+            if (dist[i][k] < 0) continue;
+            for (uint32_t j = 0; j < n; ++j) {
+                if (dist[k][j] < 0) continue;
+                int64_t through = dist[i][k] + dist[k][j];
+                if (dist[i][j] < 0 || through < dist[i][j]) dist[i][j] = through;
+            }
+        }
+    }
+    return dist;
+}
+
+// Helper: edges as <min vertex, max vertex, weight>, sorted, so two trees can be compared
+static std::vector<std::tuple<int, int, int64_t>> sortedEdges(MST& mst) {
+    std::vector<std::tuple<int, int, int64_t>> edges = mst.getEdges();
+    for (auto& edge : edges) {
+        if (std::get<0>(edge) > std::get<1>(edge)) std::swap(std::get<0>(edge), std::get<1>(edge));
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+static const QueryType QUERY_TYPES[] = {QueryType::Longest, QueryType::Shortest, QueryType::Bottleneck,
+                                        QueryType::GraphDistance};
+
+// Helper: a query of every type for every pair (in the order of QUERY_TYPES), plus out of range vertices
+static std::vector<DistanceQuery> allQueries(int n) {
+    std::vector<DistanceQuery> queries;
+    for (int u = 0; u < n; ++u) {
+        for (int v = 0; v < n; ++v) {
+            for (QueryType type : QUERY_TYPES) queries.push_back({type, u, v});
+        }
+    }
+    queries.push_back({QueryType::Longest, -1, 0});
+    queries.push_back({QueryType::Shortest, 0, n});
+    return queries;
+}
+
+// Prim, Borůvka and "auto" all find a spanning forest of the minimum weight
+static void testAlgorithmsAgree() {
+    for (auto& named : testGraphs()) {
+        const Graph& graph = named.second;
+        int64_t expected = kruskalWeight(graph);
+        for (const char* algo : ALGORITHMS) {
+            MST mst(graph, algo);
+            std::string context = named.first + ", " + algo;
+            CHECK(mst.getTotalWeight() == expected, context);
+            // A spanning forest has one edge less than vertices per component
+            CHECK(static_cast<int>(mst.getEdges().size()) == static_cast<int>(graph.getVertexCount()) -
+                                                                 mst.getComponentCount(),
+                  context);
+        }
+    }
+}
+
+// Helper: the edges of the graph as prim() and boruvka() take them, <from, to, weight, id>
+static std::vector<std::tuple<uint32_t, uint32_t, int32_t, uint32_t>> edgeList(const Graph& graph) {
+    std::vector<std::tuple<uint32_t, uint32_t, int32_t, uint32_t>> edges;
+    uint32_t n = graph.getVertexCount();
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t v = u + 1; v < n; ++v) {
+            int32_t weight = graph.getGraph()[u][v];
+            if (weight != 0) edges.emplace_back(u, v, weight, static_cast<uint32_t>(edges.size()));
+        }
+    }
+    return edges;
+}
+
+// Helper: weight of a tree returned by prim() or boruvka()
+static int64_t treeWeight(const std::vector<std::tuple<uint32_t, uint32_t, int32_t, uint32_t>>& tree) {
+    int64_t weight = 0;
+    for (const auto& edge : tree) weight += std::get<2>(edge);
+    return weight;
+}
+
+// Helper: true if text starts with prefix
+static bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+static void testRace() {
+    // The race needs one helper thread, the budget is the core count by default
+    setHelperThreadLimit(2);
+    for (auto& named : testGraphs()) {
+        const Graph& graph = named.second;
+        int64_t expected = kruskalWeight(graph);
+
+        MST mst(graph, "race");
+        const std::string& algorithm = mst.getAlgorithm();
+        const std::string& reason = mst.getSelectionReason();
+        CHECK(mst.getTotalWeight() == expected, named.first);
+        CHECK(algorithm == "prim" || algorithm == "boruvka", named.first << ": " << algorithm);
+        std::string loser = algorithm == "prim" ? "boruvka" : "prim";
+        CHECK(startsWith(reason, "race: " + algorithm + " finished first in ") &&
+                  reason.find(", " + loser + " was cancelled") != std::string::npos,
+              named.first << ": " << reason);
+
+        // The loser stops at its next check of the flag and returns nothing
+        auto edges = edgeList(graph);
+        uint32_t n = graph.getVertexCount();
+        std::atomic<bool> cancelled(true), running(false);
+        CHECK(treeWeight(prim(edges, n, &running)) == expected, named.first);
+        CHECK(treeWeight(boruvka(edges, n, &running)) == expected, named.first);
+        if (!edges.empty()) {
+            CHECK(prim(edges, n, &cancelled).empty(), named.first);
+            CHECK(boruvka(edges, n, &cancelled).empty(), named.first);
+        }
+    }
+
+    // With the budget spent there is nothing to race, the algorithm is picked as by "auto"
+    setHelperThreadLimit(1);
+    {
+        HelperThreads all(1);
+        Graph graph = testGraphs().front().second;
+        MST mst(graph, "race");
+        CHECK(mst.getTotalWeight() == kruskalWeight(graph), "race without a helper thread");
+        CHECK(startsWith(mst.getSelectionReason(), "race: no helper thread available, auto: "),
+              mst.getSelectionReason());
+    }
+    setHelperThreadLimit(0);
+}
+
+// Helper: the graph as a matrix of another weight type, every weight multiplied by scale
+template <typename W>
+static std::vector<std::vector<W>> scaledMatrix(const Graph& graph, W scale) {
+    uint32_t n = graph.getVertexCount();
+    std::vector<std::vector<W>> matrix(n, std::vector<W>(n, 0));
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t v = 0; v < n; ++v) matrix[u][v] = static_cast<W>(graph.getGraph()[u][v]) * scale;
+    }
+    return matrix;
+}
+
+// The instantiations MST never dispatches to (int64_t and float weights, uint64_t indices with narrow weights)
+// find the same forest as the narrowest one
+static void testWideInstantiations() {
+    for (auto& named : testGraphs()) {
+        const Graph& graph = named.second;
+        uint32_t n = graph.getVertexCount();
+        int64_t expected = kruskalWeight(graph);
+        int32_t maxWeight = 0;
+        for (const auto& row : graph.getGraph()) {
+            for (int32_t weight : row) maxWeight = std::max(maxWeight, weight);
+        }
+
+        for (const char* algo : ALGORITHMS) {
+            std::string context = named.first + ", " + algo;
+            MST narrow(graph, algo);
+
+            // Weights beyond int32_t
+            const int64_t scale = int64_t(1) << 20;
+            BasicMST<int64_t, uint32_t> wide(scaledMatrix<int64_t>(graph, scale), n, algo);
+            CHECK(wide.getTotalWeight() == expected * scale, context);
+            CHECK(static_cast<int>(wide.getComponentCount()) == narrow.getComponentCount(), context);
+            BasicMST<int64_t, uint64_t> wideIndex(scaledMatrix<int64_t>(graph, scale), n, algo);
+            CHECK(wideIndex.getTotalWeight() == expected * scale, context);
+            BasicMST<int32_t, uint64_t> narrowWeights(scaledMatrix<int32_t>(graph, 1), n, algo);
+            CHECK(narrowWeights.getTotalWeight() == expected, context);
+
+            // Quarters are exact in float while the weights fit its 24 bit mantissa
+            if (maxWeight < (1 << 22)) {
+                BasicMST<float, uint32_t> real(scaledMatrix<float>(graph, 0.25f), n, algo);
+                CHECK(real.getTotalWeight() == expected * 0.25, context);
+                BasicMST<float, uint64_t> realIndex(scaledMatrix<float>(graph, 0.25f), n, algo);
+                CHECK(realIndex.getTotalWeight() == expected * 0.25, context);
+            }
+        }
+    }
+}
+
+// A disconnected graph gives one tree per component and the analytics of every component
+static void testDisconnectedForest() {
+    // Components {0, 1, 2} (a triangle whose direct edge 0-2 is not in the MST but shorter than the tree path),
+    // {3, 4} and {5}
+    Graph graph(6);
+    graph.addEdge(0, 1, 2);
+    graph.addEdge(1, 2, 2);
+    graph.addEdge(0, 2, 3);
+    graph.addEdge(3, 4, 5);
+
+    for (const char* algo : ALGORITHMS) {
+        for (VertexOrder order : ORDERS) {
+            MST mst(graph, algo, order);
+            std::string context = std::string(algo) + ", " + vertexOrderName(order);
+            CHECK(mst.getComponentCount() == 3, context);
+            CHECK(mst.getEdges().size() == 3, context);
+            CHECK(mst.getTotalWeight() == 9, context);
+
+            const int components[] = {0, 0, 0, 1, 1, 2};
+            for (int v = 0; v < 6; ++v) CHECK(mst.getComponent(v) == components[v], context << ", vertex " << v);
+            CHECK(mst.getComponent(6) == -1, context);
+
+            CHECK(mst.getTotalWeightPerComponent() == std::vector<int64_t>({4, 5, 0}), context);
+            std::vector<std::vector<std::tuple<int, int, int64_t>>> trees = mst.getComponentTrees();
+            CHECK(trees.size() == 3, context);
+            if (trees.size() == 3) {
+                std::vector<std::tuple<int, int, int64_t>> triangle = trees[0];
+                for (auto& edge : triangle) {
+                    if (std::get<0>(edge) > std::get<1>(edge)) std::swap(std::get<0>(edge), std::get<1>(edge));
+                }
+                std::sort(triangle.begin(), triangle.end());
+                CHECK(triangle == (std::vector<std::tuple<int, int, int64_t>>{{0, 1, 2}, {1, 2, 2}}), context);
+                CHECK(trees[1].size() == 1 && std::get<2>(trees[1][0]) == 5, context);
+                CHECK(trees[2].empty(), context);
+            }
+            // Pairs of the triangle in the graph: 2, 2 and 3, of {3, 4}: 5
+            CHECK(mst.getAverageEdgeCountPerComponent() == std::vector<double>({7.0 / 3, 5.0, 0.0}), context);
+            CHECK(mst.getAverageEdgeCount() == 12.0 / 4, context);
+
+            // On the MST the only path from 0 to 2 goes through 1
+            CHECK(mst.getLongestDistance(0, 2) == 4, context);
+            CHECK(mst.getShortestDistance(0, 2) == 4, context);
+            CHECK(mst.getBottleneckDistance(0, 2) == 2, context);
+            CHECK(mst.getGraphDistance(0, 2) == 3, context);
+            CHECK(mst.getLongestDistance(0, 3) == -1, context);
+            CHECK(mst.getShortestDistance(2, 5) == -1, context);
+            CHECK(mst.getBottleneckDistance(4, 5) == -1, context);
+            CHECK(mst.getGraphDistance(1, 3) == -1, context);
+        }
+    }
+}
+
+// The intervals of the estimates hold the exact average distance and diameter
+static void testEstimates() {
+    for (auto& named : testGraphs()) {
+        const Graph& graph = named.second;
+        std::vector<std::vector<int64_t>> dist = allPairs(graph);
+        double total = 0, pairs = 0;
+        int64_t diameter = 0;
+        for (size_t u = 0; u < dist.size(); ++u) {
+            for (size_t v = u + 1; v < dist.size(); ++v) {
+                if (dist[u][v] < 0) continue;
+                total += dist[u][v];
+                ++pairs;
+                diameter = std::max(diameter, dist[u][v]);
+            }
+        }
+        double average = pairs > 0 ? total / pairs : 0;
+
+        MST mst(graph, "auto");
+        CHECK(std::abs(mst.getAverageEdgeCount() - average) <= 1e-9 * average, named.first);
+
+        // The graph distance queries answer the graph distances
+        std::vector<DistanceQuery> queries;
+        for (int u = 0; u < static_cast<int>(dist.size()); ++u) {
+            for (int v = 0; v < static_cast<int>(dist.size()); ++v) {
+                queries.push_back({QueryType::GraphDistance, u, v});
+            }
+        }
+        std::vector<int64_t> answers = mst.batchQuery(queries, 1);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            CHECK(answers[i] == dist[queries[i].u][queries[i].v],
+                  named.first << ", G " << queries[i].u << " " << queries[i].v);
+        }
+
+        Estimate exactDiameter = mst.estimateDiameter(0);
+        CHECK(exactDiameter.exact && exactDiameter.value == diameter, named.first);
+
+        // The average interval is a confidence interval: over many seeds it misses the exact average about
+        // as often as the confidence allows (5% at 95%), far more misses mean a wrong interval
+        const int seeds = 100;
+        int misses = 0;
+        for (uint64_t seed = 1; seed <= seeds; ++seed) {
+            Estimate estimate = mst.estimateAverageEdgeCount(0.3, 0.95, seed);
+            if (estimate.low > average * (1 + 1e-9) || average > estimate.high * (1 + 1e-9)) ++misses;
+        }
+        CHECK(misses <= seeds / 8, named.first << ": " << misses << " of " << seeds << " intervals miss " << average);
+        // An error no sample can reach computes every source
+        Estimate full = mst.estimateAverageEdgeCount(1e-9, 0.95);
+        CHECK(full.exact && std::abs(full.value - average) <= 1e-9 * average, named.first);
+
+        // The diameter bounds are not statistical, they always hold
+        for (double error : {0.01, 0.1, 0.3}) {
+            std::string context = named.first + ", error " + std::to_string(error);
+            for (uint64_t seed = 1; seed <= 3; ++seed) {
+                Estimate bound = mst.estimateDiameter(error, seed);
+                CHECK(bound.low <= diameter && diameter <= bound.high,
+                      context << ", seed " << seed << ": [" << bound.low << ", " << bound.high << "] vs "
+                              << diameter);
+                CHECK(bound.high <= bound.low * (1 + error) || bound.exact, context);
+            }
+        }
+    }
+}
+
+// The tree, the analytics and every query answer are the same in every vertex order
+static void testReorderInvariance() {
+    for (auto& named : testGraphs()) {
+        const Graph& graph = named.second;
+        int n = static_cast<int>(graph.getVertexCount());
+        std::vector<DistanceQuery> queries = allQueries(n);
+        for (const char* algo : ALGORITHMS) {
+            MST reference(graph, algo, VertexOrder::None);
+            std::vector<std::tuple<int, int, int64_t>> edges = sortedEdges(reference);
+            std::vector<int64_t> answers = reference.batchQuery(queries, 1);
+            std::vector<int> components(n);
+            for (int v = 0; v < n; ++v) components[v] = reference.getComponent(v);
+
+            for (VertexOrder order : ORDERS) {
+                MST mst(graph, algo, order);
+                std::string context = named.first + ", " + algo + ", " + vertexOrderName(order);
+                CHECK(mst.getVertexOrder() == order, context);
+                CHECK(sortedEdges(mst) == edges, context);
+                CHECK(mst.batchQuery(queries, 2) == answers, context);
+                for (int v = 0; v < n; ++v) CHECK(mst.getComponent(v) == components[v], context << ", vertex " << v);
+                CHECK(mst.getTotalWeightPerComponent() == reference.getTotalWeightPerComponent(), context);
+                // Every tree holds the edges of its component, one less than its vertices, and its weight
+                std::vector<std::vector<std::tuple<int, int, int64_t>>> trees = mst.getComponentTrees();
+                std::vector<int64_t> weights = mst.getTotalWeightPerComponent();
+                std::vector<int> sizes(trees.size(), 0);
+                for (int v = 0; v < n; ++v) ++sizes[components[v]];
+                CHECK(static_cast<int>(trees.size()) == mst.getComponentCount(), context);
+                for (size_t c = 0; c < trees.size() && c < weights.size(); ++c) {
+                    int64_t weight = 0;
+                    for (const auto& edge : trees[c]) {
+                        weight += std::get<2>(edge);
+                        CHECK(components[std::get<0>(edge)] == static_cast<int>(c) &&
+                                  components[std::get<1>(edge)] == static_cast<int>(c),
+                              context << ", component " << c);
+                    }
+                    CHECK(static_cast<int>(trees[c].size()) == sizes[c] - 1, context << ", component " << c);
+                    CHECK(weight == weights[c], context << ", component " << c);
+                }
+                CHECK(mst.getAverageEdgeCount() == reference.getAverageEdgeCount(), context);
+
+                // The single queries answer as the batch
+                for (int u = 0; u < n; u += 7) {
+                    for (int v = 0; v < n; v += 5) {
+                        const int64_t* expected = &answers[4 * (u * n + v)];
+                        CHECK(mst.getLongestDistance(u, v) == expected[0], context);
+                        CHECK(mst.getShortestDistance(u, v) == expected[1], context);
+                        CHECK(mst.getBottleneckDistance(u, v) == expected[2], context);
+                        CHECK(mst.getGraphDistance(u, v) == expected[3], context);
+                        // On the MST the path is unique, the graph can only be shorter, no edge of the path heavier
+                        CHECK(expected[0] == expected[1], context);
+                        CHECK(expected[3] <= expected[0] && expected[2] <= expected[0], context);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    testAlgorithmsAgree();
+    testRace();
+    testWideInstantiations();
+    testDisconnectedForest();
+    testEstimates();
+    testReorderInvariance();
+
+    return finishTests("mst_test");
+}
@@ -0,0 +1,81 @@
+#include "output_buffer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define OUTPUT_FLUSH_BYTES 65536 // Pending bytes that trigger a flush without waiting for the caller
+
+OutputBuffer::OutputBuffer(int socket) : socket(socket), lastSealed(true), pending(0), broken(false) {}
+
+void OutputBuffer::append(const std::string& data) {
+    append(data.data(), data.size());
+}
+
+void OutputBuffer::append(const char* data, size_t len) {
+    if (len == 0) return;
+    if (lastSealed) {
+        segments.emplace_back();
+        lastSealed = false;
+    }
+    segments.back().append(data, len);
+    pending += len;
+    if (pending >= OUTPUT_FLUSH_BYTES) flush(true);
+}
+
+void OutputBuffer::appendSegment(std::string data) {
+    if (data.empty()) return;
+    pending += data.size();
+    segments.push_back(std::move(data));
+    lastSealed = true;
+    if (pending >= OUTPUT_FLUSH_BYTES) flush(true);
+}
+
+bool OutputBuffer::flush(bool more) {
+    if (broken) {
+        segments.clear();
+        pending = 0;
+        return false;
+    }
+
+    size_t first = 0;    // first segment not fully sent
+    size_t offset = 0;   // bytes of that segment already sent
+    while (first < segments.size()) {
+        // One sendmsg for (up to IOV_MAX of) the pending segments
+        std::vector<iovec> iov;
+        for (size_t i = first; i < segments.size() && iov.size() < IOV_MAX; ++i) {
+            size_t skip = i == first ? offset : 0;
+            iov.push_back({const_cast<char*>(segments[i].data()) + skip, segments[i].size() - skip});
+        }
+        msghdr message{};
+        message.msg_iov = iov.data();
+        message.msg_iovlen = iov.size();
+
+        ssize_t n = sendmsg(socket, &message, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            broken = true;
+            break;
+        }
+
+        // Skip the segments that were sent completely
+        size_t sent = static_cast<size_t>(n);
+        while (first < segments.size() && sent >= segments[first].size() - offset) {
+            sent -= segments[first].size() - offset;
+            offset = 0;
+            ++first;
+        }
+        offset += sent;
+    }
+
+    segments.clear();
+    lastSealed = true;
+    pending = 0;
+    return !broken;
+}
+
+size_t OutputBuffer::pendingBytes() const {
+    return pending;
+}
@@ -0,0 +1,39 @@
+#ifndef OUTPUT_BUFFER_HPP
+#define OUTPUT_BUFFER_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Class: OutputBuffer
+ * Per-connection buffer of the responses sent to a client. Prompts and answers are collected and sent
+ * together, with a single sendmsg() of all the pending segments, instead of one send() per message.
+ * Small pieces are copied into the current segment, large payloads are kept as their own segment so
+ * they are sent without another copy. The buffer is flushed automatically (with MSG_MORE) once it
+ * holds OUTPUT_FLUSH_BYTES, and must be flushed before waiting for the client (LineReader does it)
+ * and before the socket is closed: the destructor does not send anything.
+ */
+class OutputBuffer {
+public:
+    explicit OutputBuffer(int socket);
+
+    void append(const std::string& data);
+    void append(const char* data, size_t len);
+    // Keeps the payload as a segment of its own, without copying it
+    void appendSegment(std::string data);
+
+    // Sends everything pending. more = the response continues right away (MSG_MORE)
+    // Returns false once the client is gone, later output is then dropped.
+    bool flush(bool more = false);
+
+    size_t pendingBytes() const;
+
+private:
+    int socket;
+    std::vector<std::string> segments;
+    bool lastSealed; // the last segment is a payload of its own, small pieces start a new segment
+    size_t pending;
+    bool broken;
+};
+
+#endif // OUTPUT_BUFFER_HPP
@@ -0,0 +1,223 @@
+// Tests of the coalesced responses (output_buffer.cpp, line_reader.cpp) and of the binary edges frame:
+//   - the pieces and the segments arrive in the order they were appended, only once flushed (or at 64 KiB),
+//     also when there are more segments than one sendmsg takes and when the socket takes them in small parts
+//   - a buffer whose client is gone drops its output and says so
+//   - LineReader flushes the pending output before it waits, and hands out the lines of one read one by one
+//   - "edges" sends "MSTE", the edge count and the little-endian edges of the MST, a quiet upload one summary
+//
+// Usage: ./output_buffer_test (exits with 1 if a check failed), "make test" builds and runs it
+
+#include "client_commands.hpp"
+#include "client_session.hpp"
+#include "line_reader.hpp"
+#include "output_buffer.hpp"
+#include "test_util.hpp"
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Helper: connected pair of sockets, first = the client, second = the server
+static std::pair<int, int> socketPair() {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0) {
+        throw std::runtime_error(std::string("socketpair failed: ") + strerror(errno));
+    }
+    return {sockets[0], sockets[1]};
+}
+
+// Helper: reads until the peer closes the connection
+static std::string readAll(int fd) {
+    std::string text;
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<size_t>(bytes));
+    }
+    return text;
+}
+
+// Helper: bytes that are already waiting on the socket, without blocking
+static std::string readAvailable(int fd) {
+    std::string text;
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        text.append(buffer, static_cast<size_t>(bytes));
+    }
+    return text;
+}
+
+static void testOrderAndFlush() {
+    auto [client, server] = socketPair();
+    OutputBuffer out(server);
+    out.append("Enter ");
+    out.append("the number: ", 12);
+    out.appendSegment("[payload]");
+    out.append(""); // nothing to send, no empty segment
+    out.appendSegment("");
+    out.append("after\n");
+    CHECK(out.pendingBytes() == 33, out.pendingBytes());
+    CHECK(readAvailable(client).empty(), "sent before the flush");
+
+    CHECK(out.flush(), "flush");
+    CHECK(out.pendingBytes() == 0, out.pendingBytes());
+    CHECK(readAvailable(client) == "Enter the number: [payload]after\n", "order");
+
+    // At 64 KiB pending the buffer sends by itself
+    std::string chunk(1000, 'x');
+    for (int i = 0; i < 70; ++i) out.append(chunk);
+    CHECK(out.pendingBytes() < 65536, out.pendingBytes());
+    CHECK(!readAvailable(client).empty(), "no flush at 64 KiB");
+    close(server);
+    close(client);
+}
+
+static void testManySegmentsAndPartialSends() {
+    auto [client, server] = socketPair();
+    // A small send buffer makes sendmsg take a part of the segments at a time
+    int size = 4096;
+    setsockopt(server, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    std::string received;
+    std::thread reader([&received, client]() { received = readAll(client); });
+
+    std::string expected;
+    {
+        OutputBuffer out(server);
+        // More segments than IOV_MAX, so one flush needs several sendmsg
+        for (int i = 0; i < 3000; ++i) {
+            std::string piece = std::to_string(i) + ",";
+            std::string payload(static_cast<size_t>(i % 50 + 1), static_cast<char>('a' + i % 26));
+            out.append(piece);
+            out.appendSegment(payload);
+            expected += piece + payload;
+        }
+        std::string large(200000, 'z');
+        out.appendSegment(large);
+        expected += large;
+        CHECK(out.flush(), "flush");
+    }
+    close(server);
+    reader.join();
+    close(client);
+    CHECK(received.size() == expected.size(), received.size() << " of " << expected.size() << " bytes");
+    CHECK(received == expected, "order of the segments");
+}
+
+static void testClientGone() {
+    auto [client, server] = socketPair();
+    close(client);
+    OutputBuffer out(server);
+    out.append("lost\n");
+    CHECK(!out.flush(), "flush to a closed client");
+    out.append("dropped\n");
+    CHECK(!out.flush(), "flush after the client is gone");
+    CHECK(out.pendingBytes() == 0, out.pendingBytes());
+    close(server);
+}
+
+static void testLineReader() {
+    auto [client, server] = socketPair();
+    OutputBuffer out(server);
+    LineReader reader(server, "first\r\nsec", &out);
+    std::string line;
+    // Bytes received before (by an async backend) come first, a line may continue in the socket
+    CHECK(reader.readLine(line) && line == "first", line);
+
+    out.append("prompt: ");
+    std::string input = "ond  \nthird\nfourth\n";
+    CHECK(write(client, input.data(), input.size()) == static_cast<ssize_t>(input.size()), "write");
+    CHECK(reader.readLine(line) && line == "second", line);
+    // The prompt was sent before the reader waited for the client
+    CHECK(readAvailable(client) == "prompt: ", "prompt not flushed");
+
+    // The remaining lines of the same read need no flush and no system call
+    out.append("not yet");
+    CHECK(reader.readLine(line) && line == "third", line);
+    CHECK(reader.readLine(line) && line == "fourth", line);
+    CHECK(out.pendingBytes() == 7, out.pendingBytes());
+
+    shutdown(client, SHUT_WR);
+    CHECK(!reader.readLine(line) && !reader.timedOut(), "end of the input");
+    CHECK(readAvailable(client) == "not yet", "output before the end of the input");
+    close(server);
+    close(client);
+}
+
+// Helper: the 32 bit little-endian value at offset of the frame
+static uint32_t readLittleEndian(const std::string& frame, size_t offset) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = value << 8 | static_cast<unsigned char>(frame[offset + i]);
+    return value;
+}
+
+static void testEdgesFrame() {
+    Graph graph(6);
+    graph.addEdge(0, 1, 7);
+    graph.addEdge(1, 2, 300);
+    graph.addEdge(0, 2, 900);
+    graph.addEdge(3, 4, 70000);
+    graph.addEdge(4, 5, 1);
+    MST mst(graph, "boruvka");
+    auto session = std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+
+    auto [client, server] = socketPair();
+    std::string input = "edges\nexit\n";
+    CHECK(write(client, input.data(), input.size()) == static_cast<ssize_t>(input.size()), "write");
+    {
+        OutputBuffer out(server);
+        LineReader reader(server, "", &out);
+        serveCommands(session, ClientLimits(), server, reader, out);
+    }
+    close(server);
+    std::string output = readAll(client);
+    close(client);
+
+    std::vector<std::tuple<int, int, int64_t>> edges = mst.getEdges();
+    size_t start = output.find(EDGE_FRAME_MAGIC);
+    CHECK(start != std::string::npos, output);
+    if (start == std::string::npos) return;
+    CHECK(output.size() >= start + 8 + 12 * edges.size(), output.size());
+    CHECK(readLittleEndian(output, start + 4) == edges.size(), readLittleEndian(output, start + 4));
+    if (output.size() < start + 8 + 12 * edges.size()) return;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        size_t offset = start + 8 + 12 * i;
+        CHECK(readLittleEndian(output, offset) == static_cast<uint32_t>(std::get<0>(edges[i])), "from " << i);
+        CHECK(readLittleEndian(output, offset + 4) == static_cast<uint32_t>(std::get<1>(edges[i])), "to " << i);
+        CHECK(static_cast<int32_t>(readLittleEndian(output, offset + 8)) == std::get<2>(edges[i]), "weight " << i);
+    }
+    // The frame is followed by the next prompt
+    CHECK(output.compare(start + 8 + 12 * edges.size(), 15, "Enter a command") == 0, output);
+}
+
+static void testQuietUpload() {
+    ClientSession session(ClientLimits{});
+    std::string input = "3\n2 quiet\n0 1 4\n1 2 5\n";
+    session.feed(input.data(), input.size());
+    std::string output = session.takeOutput();
+    CHECK(output.find("2 edges added successfully!\n") != std::string::npos, output);
+    CHECK(output.find("Enter an edge") == std::string::npos && output.find("Edge from") == std::string::npos, output);
+
+    ClientSession verbose(ClientLimits{});
+    input = "3\n2\n0 1 4\n1 2 5\n";
+    verbose.feed(input.data(), input.size());
+    output = verbose.takeOutput();
+    CHECK(output.find("Edge from 1 -> 2 with weight 5 added successfully!\n") != std::string::npos, output);
+}
+
+int main() {
+    testOrderAndFlush();
+    testManySegmentsAndPartialSends();
+    testClientGone();
+    testLineReader();
+    testEdgesFrame();
+    testQuietUpload();
+
+    return finishTests("output_buffer_test");
+}
@@ -10,22 +10,38 @@
 #include <sstream>       
 #include <vector>          
 #include "graph.hpp"       
+#include "graph_generator.hpp"
+#include "graph_store.hpp"
+#include "helper_threads.hpp"
 #include "mst.hpp"          
+#include "server_config.hpp"
+#include "io_backend.hpp"
+#include "line_reader.hpp"
+#include "client_commands.hpp"
+#include "output_buffer.hpp"
+#include "prefork.hpp"
+#include "trace.hpp"
 #include <csignal>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 
 #define PORT 8074 // Defines the port number on which the server will listen for client connections
 bool close_server=false;
+ServerConfig serverConfig;                // Startup options (limits and queue capacity)
+std::atomic<size_t> activePipelines(0);   // Clients admitted and not finished yet
 /**
  * Class: ActiveObject
  * Implements the Active Object design pattern. This class encapsulates an asynchronous task execution model,
  * where tasks (functions) are posted to an internal queue, and a dedicated worker thread processes each task
  * in sequence. This enables asynchronous processing.
+ * With more than one worker thread, the workers share the queue and run up to that many tasks at once.
  */
 class ActiveObject
 {
 private:
-    std::thread worker;                      // Worker thread that processes the tasks
+    std::vector<std::thread> workers;        // Worker threads that process the tasks
     std::queue<std::function<void()>> tasks; // Queue of tasks to be executed
     std::mutex mutex;                        // Mutex to protect access to the task queue
     std::condition_variable cv;              // Condition variable to signal the worker thread when tasks are available
@@ -34,32 +50,37 @@ private:
 public:
     
     /**
-     * Constructor: Starts the worker thread.
-     * The worker thread runs in an infinite loop, waiting for tasks to be posted in the queue.
+     * Constructor: Starts the worker threads.
+     * Every worker thread runs in an infinite loop, waiting for tasks to be posted in the queue.
      */
-    ActiveObject()
+    explicit ActiveObject(size_t threads = 1)
     {
-        worker = std::thread([this]()
-                             {
-                try {
-                    while (running) {
-                        std::function<void()> task;
-                        {
-                            std::unique_lock<std::mutex> lock(mutex);
-                            cv.wait(lock, [this]() { return !tasks.empty() || !running; });
-                            if (!running && tasks.empty()) {
-                                // std::cout << "Worker exiting: No tasks and stopped." << std::endl;
-                                return;
-                            }
-                            task = std::move(tasks.front());
-                            tasks.pop();
+        for (size_t i = 0; i < threads; ++i)
+        {
+            workers.emplace_back([this]()
+                                 {
+                while (running) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [this]() { return !tasks.empty() || !running; });
+                        if (!running && tasks.empty()) {
+                            // std::cout << "Worker exiting: No tasks and stopped." << std::endl;
+                            return;
                         }
-                        std::cout << "Executing task..." << std::endl;
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    std::cout << "Executing task..." << std::endl;
+                    TRACE_SCOPE("ActiveObject::task");
+                    // A failing task must not stop the worker, the next clients still need it
+                    try {
                         task();  // Execute the task
+                    } catch (const std::exception &e) {
+                        std::cerr << "Exception in ActiveObject worker thread: " << e.what() << std::endl;
                     }
-                } catch (const std::exception &e) {
-                    std::cerr << "Exception in ActiveObject worker thread: " << e.what() << std::endl;
                 } });
+        }
     }
 
     /**
@@ -90,9 +111,12 @@ public:
             running = false;
             cv.notify_all();
         }
-        if (worker.joinable())
+        for (std::thread &worker : workers)
         {
-            worker.join();
+            if (worker.joinable())
+            {
+                worker.join();
+            }
         }
     }
     ~ActiveObject()
@@ -101,72 +125,122 @@ public:
     }
 };
 
-Graph build_graph(int newSocket)
+// Reads the answer to a prompt, the prompts pending in the output buffer are flushed first
+std::string read_answer(LineReader &reader)
 {
-    std::string response = "----------Graph creation----------\nEnter the number of vertices: ";
-    send(newSocket, response.c_str(), response.size(), 0);
+    std::string answer;
+    if (!reader.readLine(answer))
+    {
+        throw std::runtime_error("Client disconnected");
+    }
+    return answer;
+}
 
-    char answer[1024] = {0};
-    read(newSocket, answer, 1024);
-    int numVertices = std::stoi(answer);
+// Builds the graph of the client, or sets stored (and returns an empty graph) if the client loaded a stored graph
+Graph build_graph(LineReader &reader, OutputBuffer &out, int newSocket, std::shared_ptr<const StoredGraph> &stored)
+{
+    TRACE_SCOPE_ID("build_graph", newSocket);
+    out.append("----------Graph creation----------\nEnter the number of vertices: ");
+    std::string answer = read_answer(reader);
+
+    // A stored graph comes with its MST, the algorithm is not asked
+    std::string name;
+    if (parseLoadCommand(answer, name))
+    {
+        stored = graphStore().get(name);
+        if (!stored)
+        {
+            throw std::invalid_argument("No stored graph named " + name);
+        }
+        out.append(describeStoredGraph(name, *stored));
+        return Graph();
+    }
+
+    // The graph can be generated by the server instead of uploaded
+    if (isGeneratorCommand(answer))
+    {
+        GeneratorSpec spec = parseGeneratorCommand(answer);
+        serverConfig.limits.checkVertices(spec.vertices);
+        Graph graph = generateGraph(spec);
+        out.append(describeGeneratedGraph(spec, graph) + "New graph created!\n");
+        return graph;
+    }
+
+    std::istringstream vertexStream(answer);
+    long numVertices = -1;
+    if (!(vertexStream >> numVertices))
+    {
+        throw std::invalid_argument("Invalid number of vertices");
+    }
+
+    // Reject a too large graph before its matrix is allocated
+    serverConfig.limits.checkVertices(numVertices);
 
     // Create a new graph with the given number of vertices
-    Graph graph = Graph(numVertices); 
+    Graph graph = Graph(static_cast<int>(numVertices)); 
 
-    response = "Enter the number of edges: ";
-    send(newSocket, response.c_str(), response.size(), 0);
+    out.append("Enter the number of edges: ");
 
-    answer[1024] = {0};
-    read(newSocket, answer, 1024);
-    int numEdges = std::stoi(answer);
+    // "<count> quiet": no prompt and no acknowledgement per edge, only a summary at the end
+    std::istringstream countStream(read_answer(reader));
+    long numEdges = -1;
+    std::string mode;
+    if (!(countStream >> numEdges))
+    {
+        throw std::invalid_argument("Invalid number of edges");
+    }
+    countStream >> mode;
+    bool quiet = mode == "quiet";
+    serverConfig.limits.checkEdges(numEdges);
 
     // Add edges to the graph
     for (int i = 0; i < numEdges; ++i)
     {
-        response = "Enter an edge (from, to, weight): ";
-        send(newSocket, response.c_str(), response.size(), 0);
+        if (!quiet) out.append("Enter an edge (from, to, weight): ");
 
         int from, to, weight;
-        char edgeBuffer[1024] = {0};
-        read(newSocket, edgeBuffer, 1024);
-        std::istringstream edgeStream(edgeBuffer);
-        edgeStream >> from >> to >> weight;
+        std::string edge = read_answer(reader);
+        std::istringstream edgeStream(edge);
+        if (!(edgeStream >> from >> to >> weight))
+        {
+            throw std::invalid_argument("Invalid edge: " + edge);
+        }
         graph.addEdge(from, to, weight);
-        std::string response = "Edge from " + std::to_string(from) + " -> " + std::to_string(to) +" with weight " + std::to_string(weight) + " added successfully!\n";
-        send(newSocket, response.c_str(), response.size(), 0);
+        if (!quiet)
+        {
+            out.append("Edge from " + std::to_string(from) + " -> " + std::to_string(to) + " with weight " +
+                       std::to_string(weight) + " added successfully!\n");
+        }
     }
-    response = "New graph created!\n";
-    send(newSocket, response.c_str(), response.size(), 0);
+    if (quiet) out.append(std::to_string(numEdges) + " edges added successfully!\n");
+    out.append("New graph created!\n");
 
     return graph;
 }
 
-MST build_mst(Graph graph, int newSocket)
+// Computes the MST with the given algorithm and reports it to the client
+// An unknown algorithm is rejected by MST (std::invalid_argument), it used to fall back to prim silently
+MST create_mst(const Graph& graph, const std::string &algo, OutputBuffer &out, int newSocket)
 {
-    std::string response = "----------MST creation----------\nEnter the algorithm of MST (prim or boruvka): ";
-    send(newSocket, response.c_str(), response.size(), 0);
-
-    char algoBuffer[1024] = {0};
-    read(newSocket, algoBuffer, 1024);
-    std::string algo(algoBuffer);
-
-    // if (algo != "prim" && algo != "boruvka") so make it prim
-    if (algo != "prim" && algo != "boruvka") {
-        algo = "prim";
-    }
-
-    // Trim whitespace and newline characters
-    // algo.erase(algo.find_last_not_of(" \t\n\r") + 1);
-
-    MST mst = MST(graph.getGraph(), graph.getVertexCount(), algo); // Create the MST
-    response = "MST created using " + algo + " algorithm\n";
-    send(newSocket, response.c_str(), response.size(), 0);
+    TRACE_SCOPE_ID("create_mst", newSocket);
+    MST mst = MST(graph, algo, serverConfig.reorder); // Create the MST on the narrowest weight/index types that fit the graph
+    std::cout << "MST computed on " << mst.getTypeName() << std::endl;
+    out.append(describeMSTCreation(mst));
 
     return mst;
 }
 
-void analyze_data(MST mst, int newSocket)
+MST build_mst(const Graph &graph, LineReader &reader, OutputBuffer &out, int newSocket)
+{
+    out.append("----------MST creation----------\nEnter the algorithm of MST (prim, boruvka, auto or race): ");
+    std::string algo = read_answer(reader);
+    return create_mst(graph, algo, out, newSocket);
+}
+
+
+void analyze_data(MST mst, OutputBuffer &out, int newSocket)
 {
+    TRACE_SCOPE_ID("analyze_data", newSocket);
     std::stringstream ss;
 
     ss << "----------analyze_data----------\n";
@@ -174,8 +248,20 @@ void analyze_data(MST mst, int newSocket)
     ss << "Longest Distance (e.g. 0->1):  " << mst.getLongestDistance(0, 1) << "\n";
     ss << "Shortest Distance (e.g. 0->1):  " << mst.getShortestDistance(0, 1) << "\n";
     ss << "Average Edge Count:  " << mst.getAverageEdgeCount() << "\n";
+    ss << "Components:  " << mst.getComponentCount() << "\n";
+
+    // Disconnected graph: the MST is a spanning forest, report every tree
+    if (mst.getComponentCount() > 1)
+    {
+        std::vector<int64_t> weights = mst.getTotalWeightPerComponent();
+        std::vector<double> averages = mst.getAverageEdgeCountPerComponent();
+        for (int c = 0; c < mst.getComponentCount(); ++c)
+        {
+            ss << "Component " << c << ":  Total Weight " << weights[c] << ", Average Edge Count " << averages[c] << "\n";
+        }
+    }
 
-    send(newSocket, (ss.str()).c_str(), (ss.str()).size(), 0);
+    out.append(ss.str());
 }
 
 void handleClientPipeline(int newSocket)
@@ -194,9 +280,31 @@ void handleClientPipeline(int newSocket)
     bool stage2Done = false;
     bool stage3Done = false;
 
+    // Input and output of the client, used by one stage at a time
+    OutputBuffer out(newSocket);
+    LineReader reader(newSocket, "", &out);
+
+    // Invalid input or a graph above the limits: report it and end the pipeline
+    auto fail = [&](const std::exception &e) {
+        out.append(std::string("Error: ") + e.what() + "\n");
+        out.flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stage1Done = stage2Done = stage3Done = true;
+        }
+        cv_2.notify_one();
+    };
+
     // Stage 1: Build graph
-    stage1.post([&stage2, &stage3, &cv_2, &mutex, &stage1Done, &stage2Done, &stage3Done, newSocket]() {
-        Graph graph = build_graph(newSocket);
+    stage1.post([&stage2, &stage3, &cv_2, &mutex, &stage1Done, &stage2Done, &stage3Done, &out, &reader, &fail, newSocket]() {
+        Graph graph;
+        std::shared_ptr<const StoredGraph> stored;
+        try {
+            graph = build_graph(reader, out, newSocket, stored);
+        } catch (const std::exception &e) {
+            fail(e);
+            return;
+        }
 
         // Notify Stage 1
         {
@@ -206,8 +314,17 @@ void handleClientPipeline(int newSocket)
         cv_2.notify_one();
 
         // Pass the result to the next stage
-        stage2.post([&stage3, &cv_2, &mutex, &stage2Done, &stage3Done, graph, newSocket]() {
-            MST mst = build_mst(graph, newSocket);
+        stage2.post([&stage3, &cv_2, &mutex, &stage2Done, &stage3Done, &out, &reader, &fail, graph, stored, newSocket]() mutable {
+            std::shared_ptr<const StoredGraph> session = stored;
+            try {
+                if (!session) {
+                    MST mst = build_mst(graph, reader, out, newSocket);
+                    session = std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+                }
+            } catch (const std::exception &e) {
+                fail(e);
+                return;
+            }
 
             // Notify Stage 2
             {
@@ -216,12 +333,17 @@ void handleClientPipeline(int newSocket)
             }
             cv_2.notify_one();
 
-            std::shared_ptr<MST> mstPtr = std::make_shared<MST>(mst);
-
             // Pass the result to the final stage
-            stage3.post([&cv_2, &mutex, &stage3Done, mstPtr, newSocket]() {
+            stage3.post([&cv_2, &mutex, &stage3Done, &out, &reader, &fail, session, newSocket]() {
                 std::cout << "Analyzing data 2..." << std::endl;
-                analyze_data(*mstPtr, newSocket);
+                try {
+                    analyze_data(session->mst, out, newSocket);
+                    serveCommands(session, serverConfig.limits, newSocket, reader, out);
+                } catch (const std::exception &e) {
+                    // Also ends the wait of handleClientPipeline, so the pipeline is released
+                    fail(e);
+                    return;
+                }
 
                 // Notify Stage 3
                 {
@@ -255,19 +377,30 @@ void handleClientPipeline(int newSocket)
     close(newSocket);
 }
 
-int main()
+/**
+ * Function: serve
+ * Runs one server: the listening socket and the accept loop.
+ * In prefork mode every worker process runs it on the same port.
+ */
+int serve(const ServerConfig &config)
 {
-    
     int serverFd, newSocket;
     struct sockaddr_in address;
     int addrlen = sizeof(address);
+
+    // Trace spans of this process, dumped on SIGUSR1
+    if (config.trace) traceStart();
+    setHelperThreadLimit(config.helperThreads);
+
+    // Graphs stored before the restart, then a snapshot every interval
+    if (!config.snapshotPath.empty()) graphStore().startSnapshots(config.snapshotPath, config.snapshotInterval);
     int opt = 1;
 
     // Create socket
     if ((serverFd = socket(AF_INET, SOCK_STREAM, 0)) == 0)
     {
         std::cerr << "Socket creation failed" << std::endl;
-        exit(EXIT_FAILURE);
+        return EXIT_FAILURE;
     }
 
     // Allow port reuse
@@ -275,32 +408,106 @@ int main()
     {
         std::cerr << "setsockopt failed" << std::endl;
         close(serverFd);
-        exit(EXIT_FAILURE);
+        return EXIT_FAILURE;
+    }
+
+    // Prefork mode: every worker binds the port, the kernel spreads the connections between them
+    if (config.workers > 1 && setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)))
+    {
+        std::cerr << "setsockopt SO_REUSEPORT failed" << std::endl;
+        close(serverFd);
+        return EXIT_FAILURE;
     }
 
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
+    address.sin_port = htons(config.port != 0 ? config.port : PORT);
 
     // Bind socket
     if (bind(serverFd, (struct sockaddr *)&address, sizeof(address)) < 0)
     {
         std::cerr << "Bind failed: " << strerror(errno) << std::endl;
         close(serverFd);
-        exit(EXIT_FAILURE);
+        return EXIT_FAILURE;
     }
 
     // Start listening
-    if (listen(serverFd, 3) < 0)
+    if (listen(serverFd, config.backlog) < 0)
     {
         std::cerr << "Listen failed: " << strerror(errno) << std::endl;
         close(serverFd);
-        exit(EXIT_FAILURE);
+        return EXIT_FAILURE;
     }
 
 
     std::cout << "Server is running. Waiting for clients..." << std::endl;
 
+    if (config.io != IoBackendKind::Blocking)
+    {
+        // The backend runs the upload stage for all the clients,
+        // the MST and analysis stages are shared ActiveObjects
+        ActiveObject mstStage, analyzeStage;
+        // The commands wait for their client, so the sessions run on a fixed set of threads of their own
+        // (a session waits in the queue while all of them are taken)
+        ActiveObject commandStage(static_cast<size_t>(config.threads));
+        std::unique_ptr<IoBackend> backend = makeIoBackend(config);
+        std::cout << "Using " << backend->name() << " I/O backend" << std::endl;
+        backend->run(serverFd, [&mstStage, &analyzeStage, &commandStage, &config](int socket, Graph graph,
+                                                                                  const std::string &algo,
+                                                                                  std::string pending,
+                                                                                  std::shared_ptr<const StoredGraph> stored) {
+            // Load shedding: the stages already hold as many clients as allowed
+            if (activePipelines >= config.queueCapacity) {
+                send(socket, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_NOSIGNAL);
+                close(socket);
+                return;
+            }
+            ++activePipelines;
+            // The responses of the stages are sent together, before the first command is read
+            std::shared_ptr<OutputBuffer> out = std::make_shared<OutputBuffer>(socket);
+            // Invalid input or a failure of a stage: report it and end the session
+            auto fail = [out, socket](const std::exception &e) {
+                out->append(std::string("Error: ") + e.what() + "\n");
+                out->flush();
+                close(socket);
+                --activePipelines;
+            };
+            mstStage.post([&analyzeStage, &commandStage, graph, algo, socket, pending, stored, out, fail]() mutable {
+                std::shared_ptr<const StoredGraph> session = stored;
+                try {
+                    if (!session) {
+                        MST mst = create_mst(graph, algo, *out, socket);
+                        session = std::make_shared<const StoredGraph>(StoredGraph{std::move(graph), mst});
+                    }
+                } catch (const std::exception &e) {
+                    fail(e);
+                    return;
+                }
+                analyzeStage.post([&commandStage, session, out, socket, pending, fail]() {
+                    try {
+                        analyze_data(session->mst, *out, socket);
+                    } catch (const std::exception &e) {
+                        fail(e);
+                        return;
+                    }
+                    commandStage.post([session, out, socket, pending, fail]() {
+                        try {
+                            LineReader reader(socket, pending, out.get());
+                            serveCommands(session, serverConfig.limits, socket, reader, *out);
+                        } catch (const std::exception &e) {
+                            fail(e);
+                            return;
+                        }
+                        close(socket);
+                        --activePipelines;
+                    });
+                });
+            });
+        });
+        close(serverFd);
+        return 0;
+    }
+
     // Accept clients and handle them
     while (true) {
         if ((newSocket = accept(serverFd, (struct sockaddr *)&address, (socklen_t *)&addrlen)) < 0) {
@@ -308,13 +515,48 @@ int main()
             continue; // Continue to the next iteration if accept fails
         }
 
+        // Load shedding: the number of pipelines (and of their threads) is bounded
+        if (activePipelines >= config.queueCapacity) {
+            send(newSocket, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_NOSIGNAL);
+            close(newSocket);
+            continue;
+        }
+
         std::cout << "Client connected! Starting the pipeline..." << std::endl;
 
         // Create a new thread to handle the client
-        std::thread clientThread(handleClientPipeline, newSocket);
+        ++activePipelines;
+        std::thread clientThread([newSocket]() {
+            handleClientPipeline(newSocket);
+            --activePipelines;
+        });
         clientThread.detach(); // Detach the thread to allow it to run independently 
     }
 
     close(serverFd);
     return 0;
 }
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        serverConfig = parseServerArgs(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n" << serverUsage(argv[0]) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (serverConfig.workers > 1)
+    {
+        std::cout << "Prefork mode with " << serverConfig.workers << " workers" << std::endl;
+        return runPrefork(serverConfig.workers, [](int) {
+            // A graph saved by one worker could not be loaded by a client accepted by another one
+            graphStore().disable("Stored graphs are not available in prefork mode");
+            return serve(serverConfig);
+        });
+    }
+    return serve(serverConfig);
+}
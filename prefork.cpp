@@ -0,0 +1,208 @@
+#include "prefork.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cerrno>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define QUICK_FAILURE_SECONDS 5    // A worker that fails sooner than this after its start failed quickly
+#define RESTART_BACKOFF_SECONDS 1  // First restart delay after a quick failure, doubled on every further one
+#define MAX_RESTART_BACKOFF_SECONDS 30
+#define MAX_QUICK_FAILURES 5       // The supervisor gives up after this many quick failures in a row
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) {
+    stopRequested = 1;
+}
+
+// Helper: parses a kernel cpu list such as "0-3,8,10-11"
+static std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Helper: CPUs of a NUMA node, empty if the node does not exist
+static std::vector<int> numaNodeCpus(int node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) return {};
+    return parseCpuList(list);
+}
+
+int numaNodeCount() {
+    int nodes = 0;
+    while (!numaNodeCpus(nodes).empty()) ++nodes;
+    return nodes > 0 ? nodes : 1;
+}
+
+std::vector<std::vector<int>> cpuGroups(int workers) {
+    std::vector<std::vector<int>> groups(workers);
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return groups;
+
+    // One worker per NUMA node: every worker gets the CPUs of its node
+    if (workers > 1 && workers == numaNodeCount()) {
+        for (int node = 0; node < workers; ++node) {
+            for (int cpu : numaNodeCpus(node)) {
+                if (CPU_ISSET(cpu, &allowed)) groups[node].push_back(cpu);
+            }
+        }
+        return groups;
+    }
+
+    // Otherwise consecutive CPUs are split evenly between the workers
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    }
+    if (cpus.empty()) return groups;
+    for (int w = 0; w < workers; ++w) {
+        size_t first = cpus.size() * w / workers;
+        size_t last = cpus.size() * (w + 1) / workers;
+        // More workers than CPUs: workers share a CPU
+        if (first == last) last = first + 1;
+        for (size_t i = first; i < last && i < cpus.size(); ++i) groups[w].push_back(cpus[i]);
+        if (groups[w].empty()) groups[w].push_back(cpus[w % cpus.size()]);
+    }
+    return groups;
+}
+
+// Helper: stops every running worker and waits for them
+static void stopWorkers(const std::vector<pid_t>& pids) {
+    for (pid_t p : pids) {
+        if (p > 0) kill(p, SIGTERM);
+    }
+    while (waitpid(-1, nullptr, 0) > 0 || errno == EINTR) {
+    }
+}
+
+// Helper: forks one worker, returns its pid (or -1)
+static pid_t startWorker(int worker, const std::vector<int>& cpus, const std::function<int(int)>& serve) {
+    // Nothing buffered may be written twice
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    // Child: default signal handling, pinned to its CPU group
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+    _exit(serve(worker) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int runPrefork(int workers, const std::function<int(int worker)>& serve) {
+    struct sigaction action {};
+    action.sa_handler = onStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::vector<std::vector<int>> groups = cpuGroups(workers);
+    std::vector<pid_t> pids(workers, -1);
+    std::vector<time_t> startedAt(workers, 0);
+    std::vector<int> quickFailures(workers, 0);
+    std::vector<time_t> restartAt(workers, 0); // 0: no restart pending
+    int running = 0;
+    int pending = 0;
+
+    for (int w = 0; w < workers; ++w) {
+        pids[w] = startWorker(w, groups[w], serve);
+        startedAt[w] = time(nullptr);
+        if (pids[w] > 0) ++running;
+        std::cout << "Supervisor: worker " << w << " started (pid " << pids[w] << ")" << std::endl;
+    }
+
+    while (running > 0 || pending > 0) {
+        if (stopRequested) {
+            stopWorkers(pids);
+            return 0;
+        }
+
+        // Restart the workers whose backoff is over
+        time_t now = time(nullptr);
+        for (int w = 0; w < workers; ++w) {
+            if (restartAt[w] == 0 || restartAt[w] > now) continue;
+            restartAt[w] = 0;
+            --pending;
+            pids[w] = startWorker(w, groups[w], serve);
+            startedAt[w] = now;
+            if (pids[w] > 0) ++running;
+        }
+
+        // While a restart is pending the supervisor polls, so a backoff never delays noticing another worker
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, pending > 0 ? WNOHANG : 0);
+        if (pid <= 0) {
+            if (pid < 0 && errno != EINTR && errno != ECHILD) break;
+            if (pending > 0) sleep(1);
+            continue;
+        }
+
+        int w = 0;
+        while (w < workers && pids[w] != pid) ++w;
+        if (w == workers) continue;
+        pids[w] = -1;
+        --running;
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+            std::cout << "Supervisor: worker " << w << " exited" << std::endl;
+            continue;
+        }
+
+        // The worker crashed or failed: start a new one in its place
+        if (WIFSIGNALED(status)) {
+            std::cerr << "Supervisor: worker " << w << " killed by signal " << WTERMSIG(status);
+        } else {
+            std::cerr << "Supervisor: worker " << w << " failed with status " << WEXITSTATUS(status);
+        }
+
+        // A worker that keeps failing right after its start (e.g. the port is taken) will not recover:
+        // back off between the restarts and give up after MAX_QUICK_FAILURES of them in a row
+        if (time(nullptr) - startedAt[w] < QUICK_FAILURE_SECONDS) {
+            ++quickFailures[w];
+        } else {
+            quickFailures[w] = 0;
+        }
+        if (quickFailures[w] >= MAX_QUICK_FAILURES) {
+            std::cerr << ", giving up after " << quickFailures[w] << " quick failures" << std::endl;
+            stopWorkers(pids);
+            return EXIT_FAILURE;
+        }
+        unsigned delay = 0;
+        if (quickFailures[w] > 0) {
+            delay = RESTART_BACKOFF_SECONDS << (quickFailures[w] - 1);
+            if (delay > MAX_RESTART_BACKOFF_SECONDS) delay = MAX_RESTART_BACKOFF_SECONDS;
+        }
+        std::cerr << ", restarting";
+        if (delay > 0) std::cerr << " in " << delay << "s";
+        std::cerr << std::endl;
+        restartAt[w] = time(nullptr) + delay;
+        ++pending;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef PREFORK_HPP
+#define PREFORK_HPP
+
+#include <functional>
+#include <vector>
+
+// Number of NUMA nodes of the machine (1 if it can not be detected)
+int numaNodeCount();
+
+// Splits the CPUs this process may run on into `workers` groups.
+// With one worker per NUMA node the groups are the nodes, otherwise consecutive CPUs are grouped.
+std::vector<std::vector<int>> cpuGroups(int workers);
+
+// Prefork mode: runs serve(worker) in `workers` child processes, each pinned to its own CPU group.
+// The supervisor (the calling process) restarts a worker that crashes or exits with an error,
+// and stops all the workers on SIGINT/SIGTERM. A worker failing right after its start is restarted
+// with a growing delay; after several such failures in a row the supervisor stops the other workers
+// and returns EXIT_FAILURE. serve() must not be called with threads already
+// running in the supervisor, every worker starts its own thread pool or pipeline.
+// Returns 0 once every worker exited normally (or the supervisor was stopped), EXIT_FAILURE if it gave up.
+int runPrefork(int workers, const std::function<int(int worker)>& serve);
+
+#endif // PREFORK_HPP
@@ -1,7 +1,9 @@
 #include "prim.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <tuple>
 #include <utility>
@@ -9,49 +11,71 @@
 
 using namespace std;
 
-constexpr int INF = 0x3f3f3f3f;
+#define PRIM_CANCEL_CHECK 1024 // Vertices added between two checks of the cancel flag
 
+template <typename W, typename I>
 struct Edge
 {
-	int w = INF, to = -1, id;
+	// "no vertex": every weight of W is a valid weight, so a missing edge is marked by its endpoint
+	static constexpr I NONE = numeric_limits<I>::max();
+
+	W w = 0;
+	I to = NONE, id = NONE;
+	// ties between equal weights are broken by the edge id, as in boruvka(), so the tree is the same
+	// whatever the numbering of the vertices
 	bool operator<(Edge const& other) const
 	{
-		return make_pair(w, to) < make_pair(other.w, other.to);
+		return make_tuple(w, id, to) < make_tuple(other.w, other.id, other.to);
 	}
-	Edge()
+	bool lighter(Edge const& other) const
 	{
-		w = INF;
-		to = -1;
+		return make_pair(w, id) < make_pair(other.w, other.id);
 	}
-	Edge(int _w, int _to, int _id) : w(_w), to(_to), id(_id) {}
+	Edge() {}
+	Edge(W _w, I _to, I _id) : w(_w), to(_to), id(_id) {}
 };
 
-vector<tuple<int, int, int, int>> _prim(const vector<vector<Edge>>& adj, int n)
+template <typename W, typename I>
+vector<tuple<I, I, W, I>> _prim(const vector<vector<Edge<W, I>>>& adj, I n, const atomic<bool>* cancel)
 {
-	vector<tuple<int, int, int, int>> spanning_tree;
+	const I NONE = Edge<W, I>::NONE;
+	vector<tuple<I, I, W, I>> spanning_tree;
 
-	vector<Edge> min_e(n);
-	min_e[0].w = 0;
-	set<Edge> q;
-	q.insert({0, 0, -1});
+	vector<Edge<W, I>> min_e(n);
+	set<Edge<W, I>> q;
 
 	vector<bool> selected(n, false);
-	for (int i = 0; i < n; ++i)
+	I next_root = 0;
+	for (I i = 0; i < n; ++i)
 	{
-		int v = q.begin()->to;
+		// checked every PRIM_CANCEL_CHECK vertices, a relaxed load per vertex would already show in the profile
+		if (cancel && i % PRIM_CANCEL_CHECK == 0 && cancel->load(memory_order_relaxed))
+		{
+			return {};
+		}
+
+		if (q.empty())
+		{
+			// the previous component is spanned (or this is the first one),
+			// start a new tree from the next vertex that was not selected yet
+			while (selected[next_root]) ++next_root;
+			q.insert({0, next_root, NONE});
+		}
+
+		I v = q.begin()->to;
 		selected[v] = true;
 		q.erase(q.begin());
 
-		if (min_e[v].to != -1)
+		if (min_e[v].to != NONE)
 		{
 			spanning_tree.emplace_back(min_e[v].to, v, min_e[v].w, min_e[v].id);
 		}
 
-		for (Edge e: adj[v])
+		for (const Edge<W, I>& e: adj[v])
 		{
-			if (!selected[e.to] && e.w < min_e[e.to].w)
+			if (!selected[e.to] && (min_e[e.to].to == NONE || e.lighter(min_e[e.to])))
 			{
-				q.erase({min_e[e.to].w, e.to, e.id});
+				q.erase({min_e[e.to].w, e.to, min_e[e.to].id});
 				min_e[e.to] = {e.w, v, e.id};
 				q.insert({e.w, e.to, e.id});
 			}
@@ -62,18 +86,32 @@ vector<tuple<int, int, int, int>> _prim(const vector<vector<Edge>>& adj, int n)
 
 // this function returns the MST of the graph
 // that happens by using the prim algorithm
-vector<tuple<int, int, int, int>> prim(const vector<tuple<int, int, int, int>>& edges, int n)
+template <typename W, typename I>
+vector<tuple<I, I, W, I>> prim(const vector<tuple<I, I, W, I>>& edges, I n, const atomic<bool>* cancel)
 {
-	vector<vector<Edge>> adj(n);
+	vector<vector<Edge<W, I>>> adj(n);
 	for (const auto& e: edges)
 	{
-		int a, b, c, id;
+		I a, b, id;
+		W c;
 		tie(a, b, c, id) = e;
-		adj[a].push_back(Edge(c, b, id));
-		adj[b].push_back(Edge(c, a, id));
+		adj[a].push_back(Edge<W, I>(c, b, id));
+		adj[b].push_back(Edge<W, I>(c, a, id));
 	}
 
-	vector<tuple<int, int, int, int>> res = _prim(adj, n);
+	vector<tuple<I, I, W, I>> res = _prim(adj, n, cancel);
 
 	return res;
-}
\ No newline at end of file
+}
+
+// The supported instantiations
+template vector<tuple<uint32_t, uint32_t, uint8_t, uint32_t>> prim(const vector<tuple<uint32_t, uint32_t, uint8_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, uint16_t, uint32_t>> prim(const vector<tuple<uint32_t, uint32_t, uint16_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, int32_t, uint32_t>> prim(const vector<tuple<uint32_t, uint32_t, int32_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, int64_t, uint32_t>> prim(const vector<tuple<uint32_t, uint32_t, int64_t, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint32_t, uint32_t, float, uint32_t>> prim(const vector<tuple<uint32_t, uint32_t, float, uint32_t>>&, uint32_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, uint8_t, uint64_t>> prim(const vector<tuple<uint64_t, uint64_t, uint8_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, uint16_t, uint64_t>> prim(const vector<tuple<uint64_t, uint64_t, uint16_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, int32_t, uint64_t>> prim(const vector<tuple<uint64_t, uint64_t, int32_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, int64_t, uint64_t>> prim(const vector<tuple<uint64_t, uint64_t, int64_t, uint64_t>>&, uint64_t, const atomic<bool>*);
+template vector<tuple<uint64_t, uint64_t, float, uint64_t>> prim(const vector<tuple<uint64_t, uint64_t, float, uint64_t>>&, uint64_t, const atomic<bool>*);
@@ -1,6 +1,9 @@
 #ifndef PRIM_H
 #define PRIM_H
 
+#include <atomic>
+#include <cstdint>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -8,8 +11,14 @@ using namespace std;
 
 // Source: https://cp-algorithms.com/graph/mst_prim.html
 // Implementation of Prim's algorithm for finding a MST.
-// Assumptions: vector<edges> corresponds to the edges of a connected graph 
+// Edges are <from, to, weight, id> over the weight type W and the index type I
+// (instantiated for the types of BasicGraph, see graph.hpp).
+// Equal weights are ordered by the edge id, so the result does not depend on the vertex numbering
+// If the graph is disconnected the result is a minimum spanning forest:
+// a new tree is started from the next unvisited vertex once a component is spanned
+// If *cancel becomes true while the tree is computed, the computation stops and returns an empty result
 // Complexity: O(m log n)
-vector<tuple<int, int, int, int>> prim(const vector<tuple<int, int, int, int>>& edges,int n);
+template <typename W, typename I>
+vector<tuple<I, I, W, I>> prim(const vector<tuple<I, I, W, I>>& edges, I n, const atomic<bool>* cancel = nullptr);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,118 @@
+#include "server_config.hpp"
+#include "prefork.hpp"
+#include <stdexcept> // For exceptions
+
+// Helper: returns the value of "--name=value" if arg starts with "--name=", otherwise false
+static bool matchFlag(const std::string& arg, const std::string& name, std::string& value) {
+    std::string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// Helper: parses a positive number given to a flag
+static long parsePositive(const std::string& name, const std::string& value) {
+    size_t end = 0;
+    long number = -1;
+    try {
+        number = std::stol(value, &end);
+    } catch (const std::exception&) {
+    }
+    if (end != value.size() || number <= 0) {
+        throw std::invalid_argument("Invalid value for --" + name + ": " + value);
+    }
+    return number;
+}
+
+void ClientLimits::checkVertices(long vertices) const {
+    if (vertices < 0 || vertices > maxVertices) {
+        throw std::length_error("Number of vertices must be between 0 and " + std::to_string(maxVertices));
+    }
+}
+
+void ClientLimits::checkEdges(long edges) const {
+    if (edges < 0 || edges > maxEdges) {
+        throw std::length_error("Number of edges must be between 0 and " + std::to_string(maxEdges));
+    }
+}
+
+ServerConfig parseServerArgs(int argc, char* argv[]) {
+    ServerConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+        if (arg == "--trace") {
+            config.trace = true;
+        } else if (matchFlag(arg, "io", value)) {
+            if (value == "blocking") {
+                config.io = IoBackendKind::Blocking;
+            } else if (value == "epoll") {
+                config.io = IoBackendKind::Epoll;
+            } else if (value == "uring") {
+                config.io = IoBackendKind::Uring;
+            } else {
+                throw std::invalid_argument("Unknown I/O backend: " + value);
+            }
+        } else if (matchFlag(arg, "port", value)) {
+            long port = parsePositive("port", value);
+            if (port > 65535) throw std::invalid_argument("Invalid value for --port: " + value);
+            config.port = static_cast<int>(port);
+        } else if (matchFlag(arg, "workers", value)) {
+            // "numa": one worker process per NUMA node
+            config.workers = value == "numa" ? numaNodeCount() : static_cast<int>(parsePositive("workers", value));
+        } else if (matchFlag(arg, "backlog", value)) {
+            config.backlog = static_cast<int>(parsePositive("backlog", value));
+        } else if (matchFlag(arg, "queue-cap", value)) {
+            config.queueCapacity = static_cast<size_t>(parsePositive("queue-cap", value));
+        } else if (matchFlag(arg, "max-clients", value)) {
+            config.maxClients = static_cast<size_t>(parsePositive("max-clients", value));
+        } else if (matchFlag(arg, "threads", value)) {
+            config.threads = static_cast<int>(parsePositive("threads", value));
+        } else if (matchFlag(arg, "helper-threads", value)) {
+            config.helperThreads = static_cast<unsigned>(parsePositive("helper-threads", value));
+        } else if (matchFlag(arg, "max-vertices", value)) {
+            config.limits.maxVertices = parsePositive("max-vertices", value);
+        } else if (matchFlag(arg, "max-edges", value)) {
+            config.limits.maxEdges = parsePositive("max-edges", value);
+        } else if (matchFlag(arg, "max-batch", value)) {
+            config.limits.maxBatchQueries = parsePositive("max-batch", value);
+        } else if (matchFlag(arg, "idle-timeout", value)) {
+            // 0 keeps an idle client connected for good
+            config.limits.idleTimeout = value == "0" ? 0 : static_cast<unsigned>(parsePositive("idle-timeout", value));
+        } else if (matchFlag(arg, "snapshot", value)) {
+            if (value.empty()) throw std::invalid_argument("Invalid value for --snapshot: " + value);
+            config.snapshotPath = value;
+        } else if (matchFlag(arg, "snapshot-interval", value)) {
+            config.snapshotInterval = static_cast<unsigned>(parsePositive("snapshot-interval", value));
+        } else if (matchFlag(arg, "reorder", value)) {
+            config.reorder = parseVertexOrder(value);
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+    // The worker processes do not share their stored graphs, so there is nothing to snapshot
+    if (config.workers > 1 && !config.snapshotPath.empty()) {
+        throw std::invalid_argument("--snapshot cannot be used with --workers, the workers do not share stored graphs");
+    }
+    return config;
+}
+
+std::string serverUsage(const char* program) {
+    return std::string("Usage: ") + program +
+           " [--io=blocking|epoll|uring] [--port=N] [--workers=N|numa] [--backlog=N] [--queue-cap=N] [--max-clients=N]"
+           " [--threads=N] [--helper-threads=N] [--max-vertices=N] [--max-edges=N] [--max-batch=N] [--idle-timeout=SECONDS] [--trace] [--snapshot=PATH] [--snapshot-interval=SECONDS]"
+           " [--reorder=none|bfs|rcm|degree]";
+}
+
+std::string ioBackendName(IoBackendKind kind) {
+    switch (kind) {
+        case IoBackendKind::Epoll:
+            return "epoll";
+        case IoBackendKind::Uring:
+            return "uring";
+        default:
+            return "blocking";
+    }
+}
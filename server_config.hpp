@@ -0,0 +1,61 @@
+#ifndef SERVER_CONFIG_HPP
+#define SERVER_CONFIG_HPP
+
+#include <cstddef>
+#include <string>
+#include "vertex_order.hpp"
+
+// Sent to a client that is not admitted because the server is overloaded
+#define BUSY_RESPONSE "Server busy, try again later\n"
+
+// I/O backend used by the servers to talk to their clients
+enum class IoBackendKind {
+    Blocking, // one thread per client, blocking read/send (the original behaviour)
+    Epoll,    // single event loop with non-blocking sockets
+    Uring     // single event loop driven by io_uring completions (falls back to epoll)
+};
+
+// Per-client limits, checked before anything is allocated for the client
+struct ClientLimits {
+    long maxVertices = 5000;
+    long maxEdges = 1000000;
+    long maxBatchQueries = 1000000; // queries of one "batch" command
+    unsigned idleTimeout = 30;      // seconds a client may stay silent between its commands (0 = no limit)
+
+    // Throw std::length_error if the value is negative or above the limit
+    void checkVertices(long vertices) const;
+    void checkEdges(long edges) const;
+};
+
+// Startup options shared by both servers
+struct ServerConfig {
+    IoBackendKind io = IoBackendKind::Blocking;
+    int port = 0;              // 0 = the default port of the server
+    int workers = 1;           // worker processes sharing the port with SO_REUSEPORT (prefork mode if > 1)
+    int backlog = 128;         // listen() backlog
+    size_t queueCapacity = 64; // clients waiting for a worker (leader-follower) or pipelines in flight (pipeline)
+    size_t maxClients = 1024;  // clients uploading at the same time in the async I/O backends
+    int threads = 4;           // request threads: the Leader-Follower pool, the command sessions of the pipeline
+    unsigned helperThreads = 0; // threads shared by the parallel requests (see helper_threads.hpp), 0 = cores
+    ClientLimits limits;
+    bool trace = false;        // record trace spans, dumped to trace-<pid>.json on SIGUSR1
+    std::string snapshotPath;  // snapshot of the stored graphs, loaded at startup ("" = no snapshots)
+    unsigned snapshotInterval = 30; // seconds between two snapshots
+    VertexOrder reorder = VertexOrder::None; // relabelling of the vertices before the MST is computed
+};
+
+// Parses the command line flags of a server binary:
+//   --io=blocking|epoll|uring  --port=N  --workers=N|numa  --backlog=N  --queue-cap=N
+//   --max-clients=N  --threads=N  --helper-threads=N  --max-vertices=N  --max-edges=N  --max-batch=N
+//   --idle-timeout=SECONDS  --trace
+//   --snapshot=PATH  --snapshot-interval=N  --reorder=none|bfs|rcm|degree
+// Throws std::invalid_argument on an unknown flag or value.
+ServerConfig parseServerArgs(int argc, char* argv[]);
+
+// Usage line listing the flags above
+std::string serverUsage(const char* program);
+
+// Returns the flag value used for the given backend ("blocking", "epoll" or "uring")
+std::string ioBackendName(IoBackendKind kind);
+
+#endif // SERVER_CONFIG_HPP
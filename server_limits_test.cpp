@@ -0,0 +1,204 @@
+// Tests of the admission control and the per-client limits (server_config.cpp, client_session.cpp,
+// helper_threads.cpp, io_backend.cpp):
+//   - the limit flags are parsed and an invalid value is refused
+//   - a graph above --max-vertices or --max-edges is refused with an error before it is allocated
+//   - the helper threads never exceed their budget, a lease returns its threads
+//   - the event loops answer "Server busy" to a client above --max-clients and admit one again once a slot is free
+//
+// Usage: ./server_limits_test (exits with 1 if a check failed), "make test" builds and runs it
+
+#include "client_session.hpp"
+#include "helper_threads.hpp"
+#include "io_backend.hpp"
+#include "server_config.hpp"
+#include "test_util.hpp"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define VERTICES_PROMPT "Enter the number of vertices: "
+
+// Helper: parses the flags as a server binary would
+static ServerConfig parseFlags(const std::vector<std::string>& flags) {
+    std::vector<std::string> args = {"server"};
+    args.insert(args.end(), flags.begin(), flags.end());
+    std::vector<char*> argv;
+    for (std::string& arg : args) argv.push_back(&arg[0]);
+    return parseServerArgs(static_cast<int>(argv.size()), argv.data());
+}
+
+static void testLimitFlags() {
+    ServerConfig config = parseFlags({"--backlog=16", "--queue-cap=2", "--max-clients=3", "--threads=1",
+                                      "--helper-threads=2", "--max-vertices=10", "--max-edges=20", "--max-batch=5",
+                                      "--idle-timeout=0"});
+    CHECK(config.backlog == 16 && config.queueCapacity == 2 && config.maxClients == 3, "admission flags");
+    CHECK(config.threads == 1 && config.helperThreads == 2, "thread flags");
+    CHECK(config.limits.maxVertices == 10 && config.limits.maxEdges == 20, "graph limits");
+    CHECK(config.limits.maxBatchQueries == 5 && config.limits.idleTimeout == 0, "session limits");
+
+    const char* const invalid[] = {"--backlog=0",     "--queue-cap=-1",  "--max-clients=abc", "--threads=0",
+                                   "--max-vertices=", "--max-edges=1x",  "--max-batch=0",     "--idle-timeout=-5",
+                                   "--port=70000",    "--max-clients=3.5", "--limit=1"};
+    for (const char* flag : invalid) {
+        bool refused = false;
+        try {
+            parseFlags({flag});
+        } catch (const std::invalid_argument&) {
+            refused = true;
+        }
+        CHECK(refused, flag);
+    }
+}
+
+// Helper: feeds the lines to a new session, returns it with its output
+static std::string feedSession(ClientSession& session, const std::string& lines) {
+    session.feed(lines.data(), lines.size());
+    return session.takeOutput();
+}
+
+static void testGraphLimits() {
+    ClientLimits limits;
+    limits.maxVertices = 10;
+    limits.maxEdges = 2;
+
+    bool refused = false;
+    try {
+        limits.checkVertices(11);
+    } catch (const std::length_error&) {
+        refused = true;
+    }
+    CHECK(refused, "11 vertices");
+    limits.checkVertices(10);
+    limits.checkEdges(0);
+
+    const char* const tooLarge[] = {"11\n", "-1\n", "10\n3\n", "generate complete 11\n"};
+    for (const char* input : tooLarge) {
+        ClientSession session(limits);
+        std::string output = feedSession(session, input);
+        CHECK(session.isFailed() && !session.isReady(), input);
+        CHECK(output.find("Error: Number of") != std::string::npos, input << ": " << output);
+    }
+
+    ClientSession session(limits);
+    feedSession(session, "10\n2 quiet\n0 1 1\n1 2 1\nprim\n");
+    CHECK(session.isReady() && !session.isFailed(), "10 vertices, 2 edges");
+}
+
+static void testHelperThreadBudget() {
+    setHelperThreadLimit(3);
+    {
+        HelperThreads first(2);
+        CHECK(first.count() == 2, first.count());
+        {
+            HelperThreads second(5);
+            CHECK(second.count() == 1, second.count());
+            HelperThreads third(1);
+            CHECK(third.count() == 0, third.count());
+        }
+        // The threads of the destroyed leases are available again
+        HelperThreads fourth(4);
+        CHECK(fourth.count() == 1, fourth.count());
+    }
+    HelperThreads all(3);
+    CHECK(all.count() == 3, all.count());
+    setHelperThreadLimit(0);
+}
+
+// Helper: connects to the port of the loopback address, reads time out after 5 seconds
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error(std::string("connect failed: ") + strerror(errno));
+    }
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+// Helper: reads until the text ends with expected, the connection is closed or a read times out
+static std::string readUntil(int fd, const std::string& expected) {
+    std::string text;
+    char buffer[256];
+    while (text.size() < expected.size() || text.compare(text.size() - expected.size(), expected.size(), expected)) {
+        ssize_t bytes = read(fd, buffer, sizeof(buffer));
+        if (bytes <= 0) break;
+        text.append(buffer, static_cast<size_t>(bytes));
+    }
+    return text;
+}
+
+// Helper: listening socket on an ephemeral loopback port, returns it and sets port
+static int listenOnLoopback(int& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 16) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+        throw std::runtime_error(std::string("listen failed: ") + strerror(errno));
+    }
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+static void testBusyShedding() {
+    const IoBackendKind kinds[] = {IoBackendKind::Epoll, IoBackendKind::Uring};
+    for (IoBackendKind kind : kinds) {
+        std::string name = ioBackendName(kind);
+        ServerConfig config;
+        config.io = kind;
+        config.maxClients = 1;
+        int port = 0;
+        int serverFd = listenOnLoopback(port);
+        // The event loop runs for good, the thread ends with the process
+        std::shared_ptr<IoBackend> backend = makeIoBackend(config);
+        std::thread([backend, serverFd]() {
+            backend->run(serverFd, [](int socket, Graph, const std::string&, std::string,
+                                      std::shared_ptr<const StoredGraph>) { close(socket); });
+        }).detach();
+
+        int admitted = connectTo(port);
+        CHECK(readUntil(admitted, VERTICES_PROMPT).find(VERTICES_PROMPT) != std::string::npos, name);
+
+        // The only upload slot is taken: the next client is told and disconnected
+        int refused = connectTo(port);
+        CHECK(readUntil(refused, BUSY_RESPONSE) == BUSY_RESPONSE, name);
+        char byte;
+        CHECK(read(refused, &byte, 1) == 0, name);
+        close(refused);
+
+        // Once the admitted client is gone, a new one is admitted (the loop may see the close after the connect)
+        close(admitted);
+        bool readmitted = false;
+        for (int attempt = 0; attempt < 100 && !readmitted; ++attempt) {
+            int client = connectTo(port);
+            readmitted = readUntil(client, VERTICES_PROMPT).find(VERTICES_PROMPT) != std::string::npos;
+            close(client);
+            if (!readmitted) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        CHECK(readmitted, name);
+    }
+}
+
+int main() {
+    testLimitFlags();
+    testGraphLimits();
+    testHelperThreadBudget();
+    testBusyShedding();
+
+    return finishTests("server_limits_test");
+}
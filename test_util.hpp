@@ -0,0 +1,29 @@
+#ifndef TEST_UTIL_HPP
+#define TEST_UTIL_HPP
+
+// Checks shared by the test programs (*_test.cpp): a failed check is printed with its context and the
+// program goes on, finishTests() then prints the count and gives the exit status (1 if a check failed)
+
+#include <iostream>
+
+inline int testChecks = 0;
+inline int testFailures = 0;
+
+// Records one check, prints the failing ones with their context
+#define CHECK(condition, context)                                                                          \
+    do {                                                                                                   \
+        ++testChecks;                                                                                      \
+        if (!(condition)) {                                                                                \
+            ++testFailures;                                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition << " failed (" << context << ")" \
+                      << std::endl;                                                                        \
+        }                                                                                                  \
+    } while (0)
+
+// Prints the number of passed checks, returns the exit status of the test program
+inline int finishTests(const char* program) {
+    std::cout << program << ": " << testChecks - testFailures << "/" << testChecks << " checks passed" << std::endl;
+    return testFailures == 0 ? 0 : 1;
+}
+
+#endif // TEST_UTIL_HPP
@@ -0,0 +1,167 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<bool> traceEnabled(false);
+
+// One span, the fields are atomics so a dump can read a buffer while its thread writes it
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start{0};
+    std::atomic<int64_t> end{0};
+    std::atomic<int64_t> id{-1};
+    std::atomic<int64_t> tid{0};
+};
+
+// Ring buffer of one thread, written only by that thread
+struct TraceBuffer {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written{0}; // spans written so far, the newest is at (written - 1) % size
+    std::atomic<bool> inUse{true};    // false once the thread exited, the buffer is then reused
+
+    TraceBuffer() : events(TRACE_BUFFER_EVENTS) {}
+};
+
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers; // never shrinks, a dump can read any of them
+static int dumpPipe[2] = {-1, -1};
+static const int64_t traceOrigin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now().time_since_epoch()).count();
+
+// Buffer of the calling thread, handed back when the thread exits (the pipeline starts a thread per client)
+struct ThreadBuffer {
+    TraceBuffer* buffer = nullptr;
+    int64_t tid = 0;
+    ~ThreadBuffer() {
+        if (buffer) buffer->inUse.store(false, std::memory_order_release);
+    }
+};
+static thread_local ThreadBuffer threadBuffer;
+
+// Helper: takes a buffer released by an exited thread, or allocates a new one
+static TraceBuffer* acquireBuffer() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto& buffer : buffers) {
+        bool released = false;
+        if (buffer->inUse.compare_exchange_strong(released, true)) return buffer.get();
+    }
+    buffers.push_back(std::make_unique<TraceBuffer>());
+    return buffers.back().get();
+}
+
+int64_t traceNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count() - traceOrigin;
+}
+
+void traceRecord(const char* name, int64_t start, int64_t end, int64_t id) {
+    if (!threadBuffer.buffer) {
+        threadBuffer.buffer = acquireBuffer();
+        threadBuffer.tid = static_cast<int64_t>(syscall(SYS_gettid));
+    }
+    TraceBuffer& buffer = *threadBuffer.buffer;
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer.events[index % TRACE_BUFFER_EVENTS];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.id.store(id, std::memory_order_relaxed);
+    event.tid.store(threadBuffer.tid, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+// Helper: writes the spans of one buffer, skipping the ones overwritten while they were read
+static void dumpBuffer(TraceBuffer& buffer, std::ostream& out, bool& first) {
+    uint64_t written = buffer.written.load(std::memory_order_acquire);
+    uint64_t begin = written > TRACE_BUFFER_EVENTS ? written - TRACE_BUFFER_EVENTS : 0;
+
+    struct Copy {
+        const char* name;
+        int64_t start, end, id, tid;
+    };
+    std::vector<Copy> copies;
+    copies.reserve(written - begin);
+    for (uint64_t i = begin; i < written; ++i) {
+        const TraceEvent& event = buffer.events[i % TRACE_BUFFER_EVENTS];
+        copies.push_back({event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+                          event.end.load(std::memory_order_relaxed), event.id.load(std::memory_order_relaxed),
+                          event.tid.load(std::memory_order_relaxed)});
+    }
+
+    // Spans older than (now written - size) may have been overwritten during the copy
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t writtenAfter = buffer.written.load(std::memory_order_relaxed);
+    uint64_t valid = writtenAfter > TRACE_BUFFER_EVENTS ? writtenAfter - TRACE_BUFFER_EVENTS : 0;
+
+    for (uint64_t i = std::max(begin, valid); i < written; ++i) {
+        const Copy& span = copies[i - begin];
+        out << (first ? "\n" : ",\n") << "{\"name\":\"" << span.name << "\",\"ph\":\"X\",\"pid\":" << getpid()
+            << ",\"tid\":" << span.tid << ",\"ts\":" << span.start / 1000.0 << ",\"dur\":"
+            << (span.end - span.start) / 1000.0;
+        if (span.id >= 0) out << ",\"args\":{\"id\":" << span.id << "}";
+        out << "}";
+        first = false;
+    }
+}
+
+bool traceDump(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out.setf(std::ios::fixed);
+    out.precision(3);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto& buffer : buffers) dumpBuffer(*buffer, out, first);
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+// SIGUSR1 only wakes the dump thread, the JSON is not written from the signal handler
+static void onDumpSignal(int) {
+    char byte = 1;
+    ssize_t ignored = write(dumpPipe[1], &byte, 1);
+    (void)ignored;
+}
+
+void traceStart() {
+    if (traceEnabled.exchange(true)) return;
+    if (pipe(dumpPipe) != 0) {
+        std::cerr << "Trace: pipe failed, SIGUSR1 dumps are disabled\n";
+        return;
+    }
+
+    std::thread([]() {
+        char byte;
+        while (true) {
+            ssize_t n = read(dumpPipe[0], &byte, 1);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            std::string path = "trace-" + std::to_string(getpid()) + ".json";
+            if (traceDump(path)) {
+                std::cout << "Trace written to " << path << std::endl;
+            } else {
+                std::cerr << "Trace: can not write " << path << std::endl;
+            }
+        }
+    }).detach();
+
+    struct sigaction action {};
+    action.sa_handler = onDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+}
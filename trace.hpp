@@ -0,0 +1,59 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Lightweight tracing of scoped spans.
+ * TRACE_SCOPE("name") records the time from its declaration to the end of the enclosing scope into a
+ * ring buffer of the calling thread (the newest TRACE_BUFFER_EVENTS spans of every thread are kept).
+ * While tracing is disabled a span costs one relaxed atomic load; building with -DNO_TRACE removes them.
+ * The spans are written as Chrome trace-event JSON (chrome://tracing, Perfetto) by traceDump, or by the
+ * server on SIGUSR1 once traceStart was called.
+ */
+
+#define TRACE_BUFFER_EVENTS 16384 // Spans kept per thread
+
+// Enables the recording and dumps the spans to trace-<pid>.json on every SIGUSR1
+void traceStart();
+// Writes the recorded spans as Chrome trace-event JSON, returns false if the file can not be written
+bool traceDump(const std::string& path);
+
+extern std::atomic<bool> traceEnabled;
+
+// Monotonic time in nanoseconds
+int64_t traceNow();
+// Stores a finished span in the buffer of the calling thread
+void traceRecord(const char* name, int64_t start, int64_t end, int64_t id);
+
+// Span from its construction to its destruction, id (e.g. the client socket) ties the spans of one request
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, int64_t id = -1)
+        : name(name), id(id), start(traceEnabled.load(std::memory_order_relaxed) ? traceNow() : -1) {}
+    ~TraceSpan() {
+        if (start >= 0) traceRecord(name, start, traceNow(), id);
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name; // must be a string literal, only the pointer is stored
+    int64_t id;
+    int64_t start;    // -1 if tracing was disabled when the span started
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef NO_TRACE
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ID(name, id) ((void)0)
+#else
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_SCOPE_ID(name, id) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, id)
+#endif
+
+#endif // TRACE_HPP
@@ -0,0 +1,122 @@
+#include "vertex_order.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept> // For exceptions
+
+VertexOrder parseVertexOrder(const std::string& name) {
+    if (name == "none") return VertexOrder::None;
+    if (name == "bfs") return VertexOrder::BFS;
+    if (name == "rcm") return VertexOrder::RCM;
+    if (name == "degree") return VertexOrder::Degree;
+    throw std::invalid_argument("Unknown vertex order: " + name + " (none, bfs, rcm or degree)");
+}
+
+std::string vertexOrderName(VertexOrder order) {
+    switch (order) {
+        case VertexOrder::BFS:
+            return "bfs";
+        case VertexOrder::RCM:
+            return "rcm";
+        case VertexOrder::Degree:
+            return "degree";
+        default:
+            return "none";
+    }
+}
+
+// Helper: neighbours of every vertex, in increasing id order
+static std::vector<std::vector<uint32_t>> adjacencyLists(const Graph& graph) {
+    const uint32_t n = graph.getVertexCount();
+    std::vector<std::vector<uint32_t>> adjacency(n);
+    for (uint32_t u = 0; u < n; ++u) {
+        const std::vector<int32_t>& row = graph.getGraph()[u];
+        for (uint32_t v = 0; v < n; ++v) {
+            if (row[v] != 0) adjacency[u].push_back(v);
+        }
+    }
+    return adjacency;
+}
+
+// Helper: breadth-first order of all the components, every component starts from its unvisited vertex of
+// lowest degree (a cheap stand-in for a peripheral vertex). byDegree visits the neighbours by increasing degree.
+static std::vector<uint32_t> breadthFirstOrder(const std::vector<std::vector<uint32_t>>& adjacency, bool byDegree) {
+    const uint32_t n = static_cast<uint32_t>(adjacency.size());
+    std::vector<uint32_t> starts(n);
+    std::iota(starts.begin(), starts.end(), 0u);
+    std::stable_sort(starts.begin(), starts.end(),
+                     [&](uint32_t a, uint32_t b) { return adjacency[a].size() < adjacency[b].size(); });
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+    std::vector<uint32_t> neighbours;
+    for (uint32_t start : starts) {
+        if (visited[start]) continue;
+        visited[start] = 1;
+        // order doubles as the queue: the vertices after head are the ones still to expand
+        size_t head = order.size();
+        order.push_back(start);
+        while (head < order.size()) {
+            uint32_t u = order[head++];
+            neighbours.clear();
+            for (uint32_t v : adjacency[u]) {
+                if (!visited[v]) neighbours.push_back(v);
+            }
+            if (byDegree) {
+                std::stable_sort(neighbours.begin(), neighbours.end(),
+                                 [&](uint32_t a, uint32_t b) { return adjacency[a].size() < adjacency[b].size(); });
+            }
+            for (uint32_t v : neighbours) {
+                visited[v] = 1;
+                order.push_back(v);
+            }
+        }
+    }
+    return order;
+}
+
+VertexPermutation computeVertexOrder(const Graph& graph, VertexOrder order) {
+    TRACE_SCOPE("computeVertexOrder");
+    const uint32_t n = graph.getVertexCount();
+    VertexPermutation permutation;
+    permutation.toClient.resize(n);
+    std::iota(permutation.toClient.begin(), permutation.toClient.end(), 0u);
+
+    if (order == VertexOrder::BFS || order == VertexOrder::RCM) {
+        permutation.toClient = breadthFirstOrder(adjacencyLists(graph), order == VertexOrder::RCM);
+        if (order == VertexOrder::RCM) {
+            std::reverse(permutation.toClient.begin(), permutation.toClient.end());
+        }
+    } else if (order == VertexOrder::Degree) {
+        std::vector<size_t> degree(n, 0);
+        for (uint32_t u = 0; u < n; ++u) {
+            const std::vector<int32_t>& row = graph.getGraph()[u];
+            degree[u] = static_cast<size_t>(std::count_if(row.begin(), row.end(), [](int32_t w) { return w != 0; }));
+        }
+        std::stable_sort(permutation.toClient.begin(), permutation.toClient.end(),
+                         [&](uint32_t a, uint32_t b) { return degree[a] > degree[b]; });
+    }
+
+    permutation.toInternal.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        permutation.toInternal[permutation.toClient[i]] = i;
+    }
+    return permutation;
+}
+
+Graph permuteGraph(const Graph& graph, const VertexPermutation& permutation) {
+    TRACE_SCOPE("permuteGraph");
+    const uint32_t n = graph.getVertexCount();
+    const std::vector<std::vector<int32_t>>& matrix = graph.getGraph();
+    std::vector<std::vector<int32_t>> permuted(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        // Row i is the row of its client vertex with the columns renamed
+        const std::vector<int32_t>& row = matrix[permutation.toClient[i]];
+        permuted[i].resize(n);
+        for (uint32_t j = 0; j < n; ++j) {
+            permuted[i][j] = row[permutation.toClient[j]];
+        }
+    }
+    return Graph(std::move(permuted));
+}
@@ -0,0 +1,34 @@
+#ifndef VERTEX_ORDER_HPP
+#define VERTEX_ORDER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "graph.hpp"
+
+// Relabelling of the vertices applied to a graph before its MST is computed, so neighbours get close ids:
+// the edge lists, the adjacency lists of Prim, the component arrays of Borůvka and the distance arrays
+// of the traversals are then walked with fewer cache misses than with the ids uploaded by the client.
+enum class VertexOrder {
+    None,   // the ids of the client
+    BFS,    // breadth-first order from the vertex of lowest degree of every component
+    RCM,    // reverse Cuthill-McKee: BFS visiting neighbours by increasing degree, reversed (smallest bandwidth)
+    Degree  // by decreasing degree, the hubs first
+};
+
+// Both directions of a relabelling, toInternal[client id] = new id and toClient[new id] = client id
+struct VertexPermutation {
+    std::vector<uint32_t> toInternal;
+    std::vector<uint32_t> toClient;
+};
+
+// Parses "none", "bfs", "rcm" or "degree", throws std::invalid_argument otherwise
+VertexOrder parseVertexOrder(const std::string& name);
+std::string vertexOrderName(VertexOrder order);
+
+// Computes the relabelling of the graph in the given order, O(n^2) for the scan of the matrix
+VertexPermutation computeVertexOrder(const Graph& graph, VertexOrder order);
+// The graph with vertex v renamed to permutation.toInternal[v]
+Graph permuteGraph(const Graph& graph, const VertexPermutation& permutation);
+
+#endif // VERTEX_ORDER_HPP